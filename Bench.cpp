@@ -0,0 +1,265 @@
+// Micro-benchmarks for Board's hot paths, built as a separate program:
+//   g++ -std=c++17 -O2 -pthread Bitboard.cpp Board.cpp Piece.cpp Bench.cpp -o chess_bench
+//
+// chess_bench [--time ms] [--json file|-] [--baseline file] [--threshold percent]
+
+#include "Board.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Every heap allocation in the program is counted so each benchmark can
+// report allocations per operation
+static std::atomic<uint64_t> allocationCount(0);
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+// Openings, middlegames and endgames, chosen to cover castling, en passant,
+// promotions, pins and checks
+static const char* const CORPUS[] = {
+    // Openings
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "rnbqkb1r/pp2pppp/3p1n2/8/3NP3/8/PPP2PPP/RNBQKB1R w KQkq - 1 5",
+    "r1bqkbnr/pppp1ppp/2n5/1B2p3/4P3/5N2/PPPP1PPP/RNBQK2R b KQkq - 3 3",
+    "rnbqkb1r/ppp1pppp/5n2/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 3",
+    // Middlegames
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    // Endgames
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "1K1k4/1P6/8/8/8/8/r7/2R5 w - - 0 1",
+    "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1",
+    "6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1",
+};
+
+struct BenchResult {
+    std::string name;
+    uint64_t ops;
+    double nsPerOp;
+    double allocationsPerOp;
+};
+
+// One timed pass over the corpus; returns the number of operations done
+typedef std::function<uint64_t(const Board&)> BenchPass;
+
+static volatile uint64_t sink;
+
+static BenchResult runBench(const std::string& name, const std::vector<Board>& corpus,
+                            const BenchPass& pass, int milliseconds) {
+    // Warm up caches and branch predictors
+    for (const Board& board : corpus) {
+        sink = sink + pass(board);
+    }
+
+    uint64_t ops = 0;
+    uint64_t allocationsBefore = allocationCount.load();
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(milliseconds);
+    auto now = start;
+    do {
+        for (const Board& board : corpus) {
+            ops += pass(board);
+        }
+        now = std::chrono::steady_clock::now();
+    } while (now < deadline);
+    uint64_t allocations = allocationCount.load() - allocationsBefore;
+
+    double ns = std::chrono::duration<double, std::nano>(now - start).count();
+    return BenchResult{name, ops, ns / ops, static_cast<double>(allocations) / ops};
+}
+
+static std::vector<BenchResult> runAll(const std::vector<Board>& corpus, int milliseconds) {
+    std::vector<BenchResult> results;
+
+    results.push_back(runBench("isValidMove", corpus, [](const Board& board) {
+        // Every own piece to every square, legal or not
+        uint64_t ops = 0;
+        for (int from = 0; from < 64; from++) {
+            const Piece* piece = board.getPiece(Position(rowOf(from), colOf(from)));
+            if (!piece || piece->isWhite() != board.isWhiteTurn) continue;
+            for (int to = 0; to < 64; to++) {
+                sink = sink + board.isValidMove(Position(rowOf(from), colOf(from)), Position(rowOf(to), colOf(to)));
+                ops++;
+            }
+        }
+        return ops;
+    }, milliseconds));
+
+    results.push_back(runBench("getValidMoves", corpus, [](const Board& board) {
+        uint64_t ops = 0;
+        for (int sq = 0; sq < 64; sq++) {
+            const Piece* piece = board.getPiece(Position(rowOf(sq), colOf(sq)));
+            if (!piece || piece->isWhite() != board.isWhiteTurn) continue;
+            sink = sink + board.getValidMoves(Position(rowOf(sq), colOf(sq))).size();
+            ops++;
+        }
+        return ops;
+    }, milliseconds));
+
+    results.push_back(runBench("isInCheck", corpus, [](const Board& board) {
+        sink = sink + board.isInCheck(board.isWhiteTurn) + board.isInCheck(!board.isWhiteTurn);
+        return uint64_t(2);
+    }, milliseconds));
+
+    results.push_back(runBench("isCheckmate", corpus, [](const Board& board) {
+        sink = sink + board.isCheckmate(board.isWhiteTurn);
+        return uint64_t(1);
+    }, milliseconds));
+
+    results.push_back(runBench("legalMoves", corpus, [](const Board& board) {
+        MoveList moves;
+        board.generateLegalMoves(board.isWhiteTurn ? WHITE : BLACK, moves);
+        sink = sink + moves.size();
+        return uint64_t(1);
+    }, milliseconds));
+
+    results.push_back(runBench("copy", corpus, [](const Board& board) {
+        Board copy = board;
+        sink = sink + copy.hash();
+        return uint64_t(1);
+    }, milliseconds));
+
+    results.push_back(runBench("makeMove", corpus, [](const Board& board) {
+        // Each legal move played on a fresh copy of the position
+        MoveList moves;
+        board.generateLegalMoves(board.isWhiteTurn ? WHITE : BLACK, moves);
+        for (Move move : moves) {
+            Board copy = board;
+            char promotion = (moveKind(move) == PROMOTION) ? "NBRQ"[promotionType(move) - KNIGHT] : 'Q';
+            sink = sink + copy.makeMove(Position(rowOf(moveFrom(move)), colOf(moveFrom(move))),
+                                        Position(rowOf(moveTo(move)), colOf(moveTo(move))), promotion);
+        }
+        return uint64_t(moves.size());
+    }, milliseconds));
+
+    results.push_back(runBench("toString", corpus, [](const Board& board) {
+        sink = sink + board.toString().size();
+        return uint64_t(1);
+    }, milliseconds));
+
+    return results;
+}
+
+static std::string toJson(const std::vector<BenchResult>& results) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    out << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"ops\": " << r.ops
+            << ", \"ns_per_op\": " << r.nsPerOp
+            << ", \"allocs_per_op\": " << r.allocationsPerOp << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return out.str();
+}
+
+// Reads ns_per_op per name back from a file written by toJson
+static std::map<std::string, double> readBaseline(const std::string& path) {
+    std::map<std::string, double> baseline;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t name = line.find("\"name\": \"");
+        size_t ns = line.find("\"ns_per_op\": ");
+        if (name == std::string::npos || ns == std::string::npos) continue;
+        name += 9;
+        baseline[line.substr(name, line.find('"', name) - name)] = std::atof(line.c_str() + ns + 13);
+    }
+    return baseline;
+}
+
+int main(int argc, char* argv[]) {
+    int milliseconds = 300;
+    std::string jsonPath;
+    std::string baselinePath;
+    double threshold = 10.0;  // Percent slowdown counted as a regression
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        if (option == "--time") milliseconds = std::atoi(argv[i + 1]);
+        else if (option == "--json") jsonPath = argv[i + 1];
+        else if (option == "--baseline") baselinePath = argv[i + 1];
+        else if (option == "--threshold") threshold = std::atof(argv[i + 1]);
+        else {
+            std::cerr << "Usage: chess_bench [--time ms] [--json file|-] [--baseline file] [--threshold percent]\n";
+            return 1;
+        }
+    }
+
+    std::vector<Board> corpus;
+    for (const char* fen : CORPUS) {
+        Board board;
+        board.fromFEN(fen);
+        corpus.push_back(board);
+    }
+
+    std::vector<BenchResult> results = runAll(corpus, milliseconds);
+
+    if (jsonPath == "-") {
+        std::cout << toJson(results);
+    } else {
+        if (!jsonPath.empty()) {
+            std::ofstream(jsonPath) << toJson(results);
+        }
+        std::cout << std::left << std::setw(16) << "benchmark" << std::right
+                  << std::setw(12) << "ns/op" << std::setw(12) << "allocs/op" << "\n";
+        for (const BenchResult& r : results) {
+            std::cout << std::left << std::setw(16) << r.name << std::right << std::fixed
+                      << std::setprecision(1) << std::setw(12) << r.nsPerOp
+                      << std::setprecision(2) << std::setw(12) << r.allocationsPerOp << "\n";
+        }
+    }
+
+    if (baselinePath.empty()) {
+        return 0;
+    }
+
+    std::map<std::string, double> baseline = readBaseline(baselinePath);
+    if (baseline.empty()) {
+        std::cerr << "No benchmarks found in " << baselinePath << "\n";
+        return 1;
+    }
+    bool regressed = false;
+    std::cerr << "\n" << std::left << std::setw(16) << "benchmark" << std::right
+              << std::setw(12) << "baseline" << std::setw(12) << "now" << std::setw(10) << "change" << "\n";
+    for (const BenchResult& r : results) {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end() || it->second <= 0) continue;
+        double change = (r.nsPerOp / it->second - 1.0) * 100.0;
+        bool slower = change > threshold;
+        regressed = regressed || slower;
+        std::cerr << std::left << std::setw(16) << r.name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(12) << it->second << std::setw(12) << r.nsPerOp
+                  << std::setw(9) << std::showpos << change << std::noshowpos << "%"
+                  << (slower ? "  REGRESSION" : "") << "\n";
+    }
+    return regressed ? 2 : 0;
+}
@@ -0,0 +1,109 @@
+#include "Bitboard.h"
+#include <mutex>
+
+Magic ROOK_MAGICS[64];
+Magic BISHOP_MAGICS[64];
+
+static Bitboard rookTable[0x19000];   // Sum over squares of 2^(relevant rook blockers)
+static Bitboard bishopTable[0x1480];  // Same for bishops
+
+static const int ROOK_DIRECTIONS[4][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
+static const int BISHOP_DIRECTIONS[4][2] = { {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
+
+// Walk the four rays from sq until the edge of the board or the first occupied
+// square. Only used to build the lookup tables.
+static Bitboard slidingAttacks(int sq, Bitboard occupied, const int (&directions)[4][2]) {
+    Bitboard attacks = 0;
+    for (const auto& d : directions) {
+        int row = rowOf(sq) + d[0];
+        int col = colOf(sq) + d[1];
+        while (row >= 0 && row < 8 && col >= 0 && col < 8) {
+            Bitboard b = squareBB(makeSquare(row, col));
+            attacks |= b;
+            if (occupied & b) break;
+            row += d[0];
+            col += d[1];
+        }
+    }
+    return attacks;
+}
+
+#if !defined(__BMI2__)
+// xorshift64* generator; fixed seeds keep the magic search short and repeatable
+static uint64_t nextRandom(uint64_t& state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+// Try sparse random numbers until one maps every blocker subset of the mask
+// to a slot without a destructive collision
+static void findMagic(Magic& m, const Bitboard* occupancy, const Bitboard* reference, int size,
+                      uint64_t seed, int* epoch, int& attempt) {
+    uint64_t state = seed;
+    for (int i = 0; i < size; ) {
+        for (m.magic = 0; popCount((m.magic * m.mask) >> 56) < 6; ) {
+            m.magic = nextRandom(state) & nextRandom(state) & nextRandom(state);
+        }
+
+        attempt++;
+        for (i = 0; i < size; i++) {
+            unsigned idx = m.index(occupancy[i]);
+            if (epoch[idx] < attempt) {
+                epoch[idx] = attempt;
+                m.attacks[idx] = reference[i];
+            } else if (m.attacks[idx] != reference[i]) {
+                break;
+            }
+        }
+    }
+}
+#endif
+
+static void initMagics(Magic (&magics)[64], Bitboard* table, const int (&directions)[4][2]) {
+#if !defined(__BMI2__)
+    static const uint64_t seeds[8] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+    static Bitboard occupancy[4096];
+    static Bitboard reference[4096];
+    static int epoch[4096];
+    static int attempt = 0;  // Keeps counting across both tables since epoch is shared
+#endif
+
+    for (int sq = 0; sq < 64; sq++) {
+        // Board edges never block a slider, unless the slider is on that edge
+        Bitboard edges = ((RANK_1 | RANK_8) & ~(RANK_1 << (8 * rowOf(sq)))) |
+                         ((FILE_A | FILE_H) & ~(FILE_A << colOf(sq)));
+
+        Magic& m = magics[sq];
+        m.mask = slidingAttacks(sq, 0, directions) & ~edges;
+        m.shift = 64 - popCount(m.mask);
+        m.attacks = (sq == 0) ? table : magics[sq - 1].attacks + (1 << (64 - magics[sq - 1].shift));
+
+        // Enumerate every subset of the mask (Carry-Rippler) with its attack set
+        int size = 0;
+        Bitboard subset = 0;
+        do {
+#if defined(__BMI2__)
+            m.attacks[_pext_u64(subset, m.mask)] = slidingAttacks(sq, subset, directions);
+#else
+            occupancy[size] = subset;
+            reference[size] = slidingAttacks(sq, subset, directions);
+#endif
+            size++;
+            subset = (subset - m.mask) & m.mask;
+        } while (subset);
+
+#if !defined(__BMI2__)
+        findMagic(m, occupancy, reference, size, seeds[rowOf(sq)], epoch, attempt);
+#endif
+    }
+}
+
+void initAttackTables() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        initMagics(ROOK_MAGICS, rookTable, ROOK_DIRECTIONS);
+        initMagics(BISHOP_MAGICS, bishopTable, BISHOP_DIRECTIONS);
+    });
+}
@@ -0,0 +1,179 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+// A set of squares, one bit per square. Bit 0 is a1, bit 7 is h1, bit 63 is h8,
+// so a square index is row * 8 + col (matching Position).
+typedef uint64_t Bitboard;
+
+enum Color { WHITE, BLACK };
+enum PieceType { PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING, NO_PIECE_TYPE };
+
+const int NO_SQUARE = -1;
+
+const Bitboard FILE_A = 0x0101010101010101ULL;
+const Bitboard FILE_H = FILE_A << 7;
+const Bitboard RANK_1 = 0xFFULL;
+const Bitboard RANK_8 = RANK_1 << 56;
+
+inline Color operator!(Color c) { return c == WHITE ? BLACK : WHITE; }
+
+// The fixed facts about one side, for code compiled separately for each
+// color so that directions and ranks are constants instead of branches
+template<Color Us>
+struct SideConstants {
+    static constexpr Color THEM = (Us == WHITE) ? BLACK : WHITE;
+    static constexpr int UP = (Us == WHITE) ? 8 : -8;        // Square offset of a pawn push
+    static constexpr int HOME = (Us == WHITE) ? 0 : 56;      // a-file square of the back rank
+    static constexpr Bitboard PROMOTION_RANK = (Us == WHITE) ? RANK_8 : RANK_1;
+    static constexpr Bitboard THIRD_RANK = (Us == WHITE) ? RANK_1 << 16 : RANK_1 << 40;  // Skipped by a double push
+};
+
+// Move every square by `Offset` (positive is toward rank 8); squares pushed
+// off the board are lost
+template<int Offset>
+constexpr Bitboard shiftBy(Bitboard b) {
+    if constexpr (Offset > 0) {
+        return b << Offset;
+    } else {
+        return b >> -Offset;
+    }
+}
+
+constexpr int makeSquare(int row, int col) { return row * 8 + col; }
+constexpr int rowOf(int sq) { return sq >> 3; }
+constexpr int colOf(int sq) { return sq & 7; }
+constexpr Bitboard squareBB(int sq) { return 1ULL << sq; }
+
+inline int popCount(Bitboard b) { return __builtin_popcountll(b); }
+inline int lsb(Bitboard b) { return __builtin_ctzll(b); }
+
+// Remove and return the lowest set square
+inline int popLsb(Bitboard& b) {
+    int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+// Attacks of a piece that moves by fixed offsets, built at compile time
+struct StepTable {
+    Bitboard attacks[64];
+};
+
+constexpr StepTable makeStepTable(const int (&steps)[8][2], int count) {
+    StepTable table{};
+    for (int sq = 0; sq < 64; sq++) {
+        for (int i = 0; i < count; i++) {
+            int row = rowOf(sq) + steps[i][0];
+            int col = colOf(sq) + steps[i][1];
+            if (row >= 0 && row < 8 && col >= 0 && col < 8) {
+                table.attacks[sq] |= squareBB(makeSquare(row, col));
+            }
+        }
+    }
+    return table;
+}
+
+constexpr int KNIGHT_STEPS[8][2] = { {2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2} };
+constexpr int KING_STEPS[8][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
+constexpr int WHITE_PAWN_STEPS[8][2] = { {1, 1}, {1, -1} };
+constexpr int BLACK_PAWN_STEPS[8][2] = { {-1, 1}, {-1, -1} };
+
+inline constexpr StepTable KNIGHT_ATTACKS = makeStepTable(KNIGHT_STEPS, 8);
+inline constexpr StepTable KING_ATTACKS = makeStepTable(KING_STEPS, 8);
+inline constexpr StepTable PAWN_ATTACKS[2] = { makeStepTable(WHITE_PAWN_STEPS, 2),
+                                               makeStepTable(BLACK_PAWN_STEPS, 2) };
+
+// For two squares on a shared rank, file or diagonal: the squares strictly
+// between them, and the whole line through both. Empty for other pairs.
+struct LineTables {
+    Bitboard between[64][64];
+    Bitboard line[64][64];
+};
+
+constexpr LineTables makeLineTables() {
+    LineTables tables{};
+    for (int from = 0; from < 64; from++) {
+        for (int d = 0; d < 8; d++) {
+            int rowStep = KING_STEPS[d][0];
+            int colStep = KING_STEPS[d][1];
+
+            // The line runs both ways from `from`
+            Bitboard line = squareBB(from);
+            for (int sign = -1; sign <= 1; sign += 2) {
+                int row = rowOf(from) + sign * rowStep;
+                int col = colOf(from) + sign * colStep;
+                for (; row >= 0 && row < 8 && col >= 0 && col < 8; row += sign * rowStep, col += sign * colStep) {
+                    line |= squareBB(makeSquare(row, col));
+                }
+            }
+
+            Bitboard path = 0;
+            int row = rowOf(from) + rowStep;
+            int col = colOf(from) + colStep;
+            for (; row >= 0 && row < 8 && col >= 0 && col < 8; row += rowStep, col += colStep) {
+                int to = makeSquare(row, col);
+                tables.between[from][to] = path;
+                tables.line[from][to] = line;
+                path |= squareBB(to);
+            }
+        }
+    }
+    return tables;
+}
+
+inline constexpr LineTables LINE_TABLES = makeLineTables();
+
+inline Bitboard betweenSquares(int a, int b) { return LINE_TABLES.between[a][b]; }
+inline Bitboard lineThrough(int a, int b) { return LINE_TABLES.line[a][b]; }
+
+inline Bitboard pawnAttacks(Color c, int sq) { return PAWN_ATTACKS[c].attacks[sq]; }
+inline Bitboard knightAttacks(int sq) { return KNIGHT_ATTACKS.attacks[sq]; }
+inline Bitboard kingAttacks(int sq) { return KING_ATTACKS.attacks[sq]; }
+
+// Slider lookup for one square: the relevant blocker squares are hashed to an
+// index into a shared attack table, by PEXT when the target has BMI2 and by
+// multiply-and-shift with a magic number otherwise.
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard* attacks;
+    unsigned shift;
+
+    unsigned index(Bitboard occupied) const {
+#if defined(__BMI2__)
+        return static_cast<unsigned>(_pext_u64(occupied, mask));
+#else
+        return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+extern Magic ROOK_MAGICS[64];
+extern Magic BISHOP_MAGICS[64];
+
+// Fill the slider tables. Board's constructor calls this; repeated calls are free.
+void initAttackTables();
+
+// Sliders take the full board occupancy and stop at the first blocker in
+// each direction (the blocker itself is included).
+inline Bitboard bishopAttacks(int sq, Bitboard occupied) {
+    const Magic& m = BISHOP_MAGICS[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard rookAttacks(int sq, Bitboard occupied) {
+    const Magic& m = ROOK_MAGICS[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard queenAttacks(int sq, Bitboard occupied) {
+    return bishopAttacks(sq, occupied) | rookAttacks(sq, occupied);
+}
+
+#endif // BITBOARD_H
@@ -1,275 +1,758 @@
 #include "Board.h"
+#include "Stats.h"
 #include <stdexcept>
 #include <sstream>
 #include <string>
 #include <cctype>
+#include <cstdlib>
 #include <iostream>
+#include <type_traits>
 
-Board::Board() : isWhiteTurn(true) {
-    // Initialize empty board
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            board[i][j] = nullptr;
-        }
-    }
+// Positions are copied for every search thread and trial move
+static_assert(std::is_trivially_copyable<Board>::value, "Board must copy as plain memory");
 
-    // Set up white pieces
-    board[0][0] = std::make_unique<Rook>(true);
-    board[0][1] = std::make_unique<Knight>(true);
-    board[0][2] = std::make_unique<Bishop>(true);
-    board[0][3] = std::make_unique<Queen>(true);
-    board[0][4] = std::make_unique<King>(true);
-    board[0][5] = std::make_unique<Bishop>(true);
-    board[0][6] = std::make_unique<Knight>(true);
-    board[0][7] = std::make_unique<Rook>(true);
-    for (int j = 0; j < BOARD_SIZE; j++) {
-        board[1][j] = std::make_unique<Pawn>(true);
-    }
-
-    // Set up black pieces
-    board[7][0] = std::make_unique<Rook>(false);
-    board[7][1] = std::make_unique<Knight>(false);
-    board[7][2] = std::make_unique<Bishop>(false);
-    board[7][3] = std::make_unique<Queen>(false);
-    board[7][4] = std::make_unique<King>(false);
-    board[7][5] = std::make_unique<Bishop>(false);
-    board[7][6] = std::make_unique<Knight>(false);
-    board[7][7] = std::make_unique<Rook>(false);
+Board::Board() {
+    initAttackTables();
+    clear();
+
+    const PieceType backRank[BOARD_SIZE] = { ROOK, KNIGHT, BISHOP, QUEEN, KING, BISHOP, KNIGHT, ROOK };
+
+    // Set up white and black pieces
     for (int j = 0; j < BOARD_SIZE; j++) {
-        board[6][j] = std::make_unique<Pawn>(false);
+        putPiece(WHITE, backRank[j], makeSquare(0, j));
+        putPiece(WHITE, PAWN, makeSquare(1, j));
+        putPiece(BLACK, PAWN, makeSquare(6, j));
+        putPiece(BLACK, backRank[j], makeSquare(7, j));
     }
+    castlingRights = WHITE_KINGSIDE | WHITE_QUEENSIDE | BLACK_KINGSIDE | BLACK_QUEENSIDE;
+    key = computeHash();
 }
 
-Board::Board(const Board& other) : isWhiteTurn(other.isWhiteTurn) {
-    // Deep copy the board array
-    for (int row = 0; row < 8; row++) {
-        for (int col = 0; col < 8; col++) {
-            if (other.board[row][col]) {
-                board[row][col] = other.board[row][col]->clone();
-            } else {
-                board[row][col] = nullptr;
-            }
+// Empty board, White to move, no rights
+void Board::clear() {
+    for (int c = 0; c < 2; c++) {
+        for (int t = 0; t < 6; t++) {
+            pieces[c][t] = 0;
         }
+        occupied[c] = 0;
+        kingSquare[c] = NO_SQUARE;
+    }
+    for (int sq = 0; sq < 64; sq++) {
+        squares[sq] = Piece();
     }
+    allPieces = 0;
+    castlingRights = 0;
+    enPassantSquare = NO_SQUARE;
+    halfmoveClock = 0;
+    fullmoveNumber = 1;
+    lastMove[0] = lastMove[1] = Position();
+    key = 0;
+    psqt = Score{0, 0};
+    phase = 0;
+    pawnKey = 0;
+    isWhiteTurn = true;
+}
+
+void Board::putPiece(Color color, PieceType type, int sq) {
+    Bitboard b = squareBB(sq);
+    pieces[color][type] |= b;
+    occupied[color] |= b;
+    allPieces |= b;
+    squares[sq] = Piece(color, type);
+    key ^= ZOBRIST.pieces[color][type][sq];
+    psqt += PSQT.values[color][type][sq];
+    phase += PHASE_WEIGHT[type];
+    if (type == PAWN) {
+        pawnKey ^= ZOBRIST.pieces[color][PAWN][sq];
+    }
+    if (type == KING) {
+        kingSquare[color] = sq;
+    }
+}
+
+void Board::removePiece(Color color, PieceType type, int sq) {
+    Bitboard b = ~squareBB(sq);
+    pieces[color][type] &= b;
+    occupied[color] &= b;
+    allPieces &= b;
+    squares[sq] = Piece();
+    key ^= ZOBRIST.pieces[color][type][sq];
+    psqt -= PSQT.values[color][type][sq];
+    phase -= PHASE_WEIGHT[type];
+    if (type == PAWN) {
+        pawnKey ^= ZOBRIST.pieces[color][PAWN][sq];
+    }
+}
+
+PieceType Board::pieceTypeAt(int sq) const {
+    return squares[sq].type();
+}
+
+bool Board::isCapture(Move move) const {
+    return (allPieces & squareBB(moveTo(move))) || moveKind(move) == EN_PASSANT;
 }
 
 bool Board::isValidPosition(const Position& pos) const {
-    return pos.row >= 0 && pos.row < BOARD_SIZE && 
+    return pos.row >= 0 && pos.row < BOARD_SIZE &&
            pos.col >= 0 && pos.col < BOARD_SIZE;
 }
 
-bool Board::isPathClear(const Position& from, const Position& to) const {
-    int rowStep = (to.row - from.row) ? (to.row - from.row) / abs(to.row - from.row) : 0;
-    int colStep = (to.col - from.col) ? (to.col - from.col) / abs(to.col - from.col) : 0;
-
-    Position current{from.row + rowStep, from.col + colStep};
-    while (current.row != to.row || current.col != to.col) {
-        if (board[current.row][current.col] != nullptr) {
-            return false;
+// Squares the piece on `from` can reach, ignoring castling and whether the
+// move would leave its own king in check
+Bitboard Board::pseudoMoves(int from) const {
+    Color us = (occupied[WHITE] & squareBB(from)) ? WHITE : BLACK;
+    Color them = !us;
+
+    switch (pieceTypeAt(from)) {
+        case PAWN: {
+            int forward = (us == WHITE) ? 8 : -8;
+            int startRow = (us == WHITE) ? 1 : 6;
+            Bitboard targets = 0;
+            int oneStep = from + forward;
+            if (oneStep >= 0 && oneStep < 64 && !(allPieces & squareBB(oneStep))) {
+                targets |= squareBB(oneStep);
+                int twoStep = oneStep + forward;
+                if (rowOf(from) == startRow && !(allPieces & squareBB(twoStep))) {
+                    targets |= squareBB(twoStep);
+                }
+            }
+            Bitboard capturable = occupied[them];
+            if (enPassantSquare != NO_SQUARE && us == (isWhiteTurn ? WHITE : BLACK)) {
+                capturable |= squareBB(enPassantSquare);
+            }
+            return targets | (pawnAttacks(us, from) & capturable);
         }
-        current.row += rowStep;
-        current.col += colStep;
+        case KNIGHT: return knightAttacks(from) & ~occupied[us];
+        case BISHOP: return bishopAttacks(from, allPieces) & ~occupied[us];
+        case ROOK:   return rookAttacks(from, allPieces) & ~occupied[us];
+        case QUEEN:  return queenAttacks(from, allPieces) & ~occupied[us];
+        case KING:   return kingAttacks(from) & ~occupied[us];
+        default:     return 0;
     }
-    return true;
 }
 
 bool Board::isValidMove(const Position& from, const Position& to) const {
+    STAT_SCOPE(STAT_IS_VALID_MOVE);
     if (!isValidPosition(from) || !isValidPosition(to)) {
         return false;
     }
 
-    const Piece* piece = board[from.row][from.col].get();
-    if (!piece || piece->isWhite() != isWhiteTurn) {
+    int fromSq = makeSquare(from.row, from.col);
+    Color us = isWhiteTurn ? WHITE : BLACK;
+    if (!(occupied[us] & squareBB(fromSq))) {
         return false;
     }
 
-    const Piece* targetPiece = board[to.row][to.col].get();
-    if (targetPiece && targetPiece->isWhite() == piece->isWhite()) {
-        return false;
+    // Special moves check
+    if (pieceTypeAt(fromSq) == KING && from.row == to.row && abs(to.col - from.col) == 2) {
+        return canCastle(from, to);
     }
 
-    if (!piece->isValidMove(from, to, *this)) {
+    // Most squares are out of reach anyway; only work out pins and checks
+    // for those that are not
+    Bitboard toBB = squareBB(makeSquare(to.row, to.col));
+    if (!(pseudoMoves(fromSq) & toBB)) {
         return false;
     }
+    return (legalTargets(fromSq, us, checkInfo(us)) & toBB) != 0;
+}
 
-    // Special moves check
-    if (dynamic_cast<const King*>(piece)) {
-        if (abs(to.col - from.col) == 2) {
-            return canCastle(from, to);
-        }
-    } else if (dynamic_cast<const Pawn*>(piece)) {
-        if (from.col != to.col && !targetPiece) {
-            return isEnPassantMove(from, to);
-        }
+bool Board::isLegalMove(Move move) const {
+    if (move == NO_MOVE) {
+        return false;
     }
+    Position from(rowOf(moveFrom(move)), colOf(moveFrom(move)));
+    Position to(rowOf(moveTo(move)), colOf(moveTo(move)));
+    char promotion = (moveKind(move) == PROMOTION) ? "NBRQ"[promotionType(move) - KNIGHT] : 'Q';
 
-    return isPathClear(from, to) && !wouldBeInCheck(from, to, piece->isWhite());
+    // The encoding has to be the one this position would give the move
+    return isValidMove(from, to) && toMove(from, to, promotion) == move;
 }
 
-void Board::movePiece(const Position& from, const Position& to) {
-    if (board[from.row][from.col]) {
-        // Handle en passant capture
-        if (dynamic_cast<Pawn*>(board[from.row][from.col].get()) && 
-            from.col != to.col && 
-            !board[to.row][to.col]) {
-            board[from.row][to.col] = nullptr; // Capture en passant pawn
+Move Board::toMove(const Position& from, const Position& to, char promotionPiece) const {
+    int fromSq = makeSquare(from.row, from.col);
+    int toSq = makeSquare(to.row, to.col);
+    PieceType type = pieceTypeAt(fromSq);
+
+    if (type == KING && abs(to.col - from.col) == 2) {
+        return encodeMove(fromSq, toSq, CASTLING);
+    }
+    if (type == PAWN && toSq == enPassantSquare) {
+        return encodeMove(fromSq, toSq, EN_PASSANT);
+    }
+    if (type == PAWN && (to.row == 0 || to.row == BOARD_SIZE - 1)) {
+        PieceType promotion;
+        switch (promotionPiece) {
+            case 'R': promotion = ROOK; break;
+            case 'B': promotion = BISHOP; break;
+            case 'N': promotion = KNIGHT; break;
+            default: promotion = QUEEN; break;
         }
+        return encodeMove(fromSq, toSq, PROMOTION, promotion);
+    }
+    return encodeMove(fromSq, toSq);
+}
 
-        // Handle castling
-        if (dynamic_cast<King*>(board[from.row][from.col].get()) && 
-            abs(to.col - from.col) == 2) {
-            int rookFromCol = (to.col > from.col) ? 7 : 0;
-            int rookToCol = (to.col > from.col) ? 5 : 3;
-            board[to.row][rookToCol] = std::move(board[to.row][rookFromCol]);
+// Move the pieces for a move and update castling and en passant state
+template<Color Us>
+void Board::relocatePieces(Move move) {
+    using Side = SideConstants<Us>;
+    constexpr Color them = Side::THEM;
+    int fromSq = moveFrom(move);
+    int toSq = moveTo(move);
+    MoveKind kind = moveKind(move);
+    PieceType type = pieceTypeAt(fromSq);
+
+    // The old en passant file leaves the key before any pawn moves, while the
+    // test that put it there still gives the same answer
+    if (enPassantSquare != NO_SQUARE && (pawnAttacks(them, enPassantSquare) & pieces[Us][PAWN])) {
+        key ^= ZOBRIST.enPassant[colOf(enPassantSquare)];
+    }
+
+    // Pawn moves and captures reset the fifty-move count
+    bool capture = (occupied[them] & squareBB(toSq)) || kind == EN_PASSANT;
+    halfmoveClock = (type == PAWN || capture) ? 0 : halfmoveClock + 1;
+    if constexpr (Us == BLACK) {
+        fullmoveNumber++;
+    }
+
+    // Regular capture
+    if (occupied[them] & squareBB(toSq)) {
+        removePiece(them, pieceTypeAt(toSq), toSq);
+    }
+
+    // Handle en passant capture
+    if (kind == EN_PASSANT) {
+        removePiece(them, PAWN, toSq - Side::UP);
+    }
+
+    // Handle castling
+    if (kind == CASTLING) {
+        bool kingside = toSq > fromSq;
+        removePiece(Us, ROOK, Side::HOME + (kingside ? 7 : 0));
+        putPiece(Us, ROOK, Side::HOME + (kingside ? 5 : 3));
+    }
+
+    removePiece(Us, type, fromSq);
+    putPiece(Us, kind == PROMOTION ? promotionType(move) : type, toSq);
+
+    // A king or rook leaving its home square, or a rook being captured there,
+    // gives up the matching castling rights
+    key ^= ZOBRIST.castling[castlingRights];
+    auto clearRights = [this](int sq) {
+        switch (sq) {
+            case 0:  castlingRights &= ~WHITE_QUEENSIDE; break;
+            case 4:  castlingRights &= ~(WHITE_KINGSIDE | WHITE_QUEENSIDE); break;
+            case 7:  castlingRights &= ~WHITE_KINGSIDE; break;
+            case 56: castlingRights &= ~BLACK_QUEENSIDE; break;
+            case 60: castlingRights &= ~(BLACK_KINGSIDE | BLACK_QUEENSIDE); break;
+            case 63: castlingRights &= ~BLACK_KINGSIDE; break;
         }
+    };
+    clearRights(fromSq);
+    clearRights(toSq);
+    key ^= ZOBRIST.castling[castlingRights];
+
+    // A double pawn push makes the skipped square capturable for one move.
+    // Its file is only hashed when an enemy pawn stands ready to capture.
+    enPassantSquare = NO_SQUARE;
+    if (type == PAWN && toSq - fromSq == 2 * Side::UP) {
+        enPassantSquare = fromSq + Side::UP;
+        if (pawnAttacks(Us, enPassantSquare) & pieces[them][PAWN]) {
+            key ^= ZOBRIST.enPassant[colOf(enPassantSquare)];
+        }
+    }
 
-        board[to.row][to.col] = std::move(board[from.row][from.col]);
-        lastMove[0] = from;
-        lastMove[1] = to;
+    lastMove[0] = Position(rowOf(fromSq), colOf(fromSq));
+    lastMove[1] = Position(rowOf(toSq), colOf(toSq));
+}
+
+void Board::relocatePieces(Move move) {
+    Bitboard from = squareBB(moveFrom(move));
+    if (occupied[WHITE] & from) {
+        relocatePieces<WHITE>(move);
+    } else if (occupied[BLACK] & from) {
+        relocatePieces<BLACK>(move);
     }
 }
 
-bool Board::makeMove(const Position& from, const Position& to) {
+void Board::switchSide() {
+    isWhiteTurn = !isWhiteTurn;
+    key ^= ZOBRIST.blackToMove;
+}
+
+bool Board::makeMove(const Position& from, const Position& to, char promotionPiece) {
     if (!isValidMove(from, to)) {
         return false;
     }
 
-    movePiece(from, to);
-    isWhiteTurn = !isWhiteTurn;
+    // Pawns reaching the last rank are promoted as part of the move
+    relocatePieces(toMove(from, to, promotionPiece));
+    switchSide();
     return true;
 }
 
+// Reverse lookup: place each kind of piece on sq and see whether it would hit
+// an enemy piece of the same kind
+bool Board::isSquareAttacked(int sq, Color by) const {
+    const Bitboard* them = pieces[by];
+    return (pawnAttacks(!by, sq) & them[PAWN]) ||
+           (knightAttacks(sq) & them[KNIGHT]) ||
+           (kingAttacks(sq) & them[KING]) ||
+           (bishopAttacks(sq, allPieces) & (them[BISHOP] | them[QUEEN])) ||
+           (rookAttacks(sq, allPieces) & (them[ROOK] | them[QUEEN]));
+}
+
+Bitboard Board::attackersTo(int sq, Bitboard occupancy) const {
+    Bitboard diagonal = pieces[WHITE][BISHOP] | pieces[BLACK][BISHOP] | pieces[WHITE][QUEEN] | pieces[BLACK][QUEEN];
+    Bitboard straight = pieces[WHITE][ROOK] | pieces[BLACK][ROOK] | pieces[WHITE][QUEEN] | pieces[BLACK][QUEEN];
+    return (pawnAttacks(BLACK, sq) & pieces[WHITE][PAWN]) |
+           (pawnAttacks(WHITE, sq) & pieces[BLACK][PAWN]) |
+           (knightAttacks(sq) & (pieces[WHITE][KNIGHT] | pieces[BLACK][KNIGHT])) |
+           (kingAttacks(sq) & (pieces[WHITE][KING] | pieces[BLACK][KING])) |
+           (bishopAttacks(sq, occupancy) & diagonal) |
+           (rookAttacks(sq, occupancy) & straight);
+}
+
+template<Color Us>
+Bitboard Board::computeAttacks() const {
+    using Side = SideConstants<Us>;
+    const Bitboard* own = pieces[Us];
+    Bitboard pawns = own[PAWN];
+    Bitboard attacks = shiftBy<Side::UP - 1>(pawns & ~FILE_A) | shiftBy<Side::UP + 1>(pawns & ~FILE_H);
+
+    Bitboard knights = own[KNIGHT];
+    while (knights) attacks |= knightAttacks(popLsb(knights));
+
+    Bitboard diagonal = own[BISHOP] | own[QUEEN];
+    while (diagonal) attacks |= bishopAttacks(popLsb(diagonal), allPieces);
+
+    Bitboard straight = own[ROOK] | own[QUEEN];
+    while (straight) attacks |= rookAttacks(popLsb(straight), allPieces);
+
+    if (own[KING]) attacks |= kingAttacks(kingSquare[Us]);
+    return attacks;
+}
+
+Bitboard Board::attackedSquares(Color side) const {
+    return (side == WHITE) ? computeAttacks<WHITE>() : computeAttacks<BLACK>();
+}
+
+// Full recomputation of hash(), for loading positions and for checking the
+// incremental updates
+uint64_t Board::computeHash() const {
+    uint64_t h = ZOBRIST.castling[castlingRights];
+    for (int c = 0; c < 2; c++) {
+        for (int t = PAWN; t <= KING; t++) {
+            Bitboard b = pieces[c][t];
+            while (b) h ^= ZOBRIST.pieces[c][t][popLsb(b)];
+        }
+    }
+    if (!isWhiteTurn) h ^= ZOBRIST.blackToMove;
+
+    // The en passant file only counts when a pawn of the side to move can
+    // capture there; otherwise the position is the same as without it
+    Color us = isWhiteTurn ? WHITE : BLACK;
+    if (enPassantSquare != NO_SQUARE && (pawnAttacks(!us, enPassantSquare) & pieces[us][PAWN])) {
+        h ^= ZOBRIST.enPassant[colOf(enPassantSquare)];
+    }
+    return h;
+}
+
 bool Board::isInCheck(bool isWhite) const {
-    Position kingPos{-1, -1};
+    STAT_SCOPE(STAT_IS_IN_CHECK);
+    Color us = isWhite ? WHITE : BLACK;
+    return pieces[us][KING] && isSquareAttacked(kingSquare[us], !us);
+}
 
-    // Find the king
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            const Piece* piece = board[i][j].get();
-            if (piece && dynamic_cast<const King*>(piece) && piece->isWhite() == isWhite) {
-                kingPos = Position{i, j};
-                break;
+void Board::saveUndo(Move move, UndoInfo& undo) const {
+    int toSq = moveTo(move);
+
+    undo.move = move;
+    undo.moved = pieceTypeAt(moveFrom(move));
+    undo.captured = (allPieces & squareBB(toSq)) ? pieceTypeAt(toSq) : NO_PIECE_TYPE;
+    if (moveKind(move) == EN_PASSANT) {
+        undo.captured = PAWN;
+    }
+    undo.castlingRights = castlingRights;
+    undo.enPassantSquare = enPassantSquare;
+    undo.lastMove[0] = lastMove[0];
+    undo.lastMove[1] = lastMove[1];
+    undo.key = key;
+    undo.halfmoveClock = halfmoveClock;
+    undo.fullmoveNumber = fullmoveNumber;
+}
+
+void Board::doMove(Move move, UndoInfo& undo) {
+    saveUndo(move, undo);
+    relocatePieces(move);
+    switchSide();
+}
+
+void Board::doMove(const Position& from, const Position& to, UndoInfo& undo) {
+    doMove(toMove(from, to, 'Q'), undo);
+}
+
+template<Color Us>
+void Board::restorePieces(const UndoInfo& undo) {
+    using Side = SideConstants<Us>;
+    int fromSq = moveFrom(undo.move);
+    int toSq = moveTo(undo.move);
+    MoveKind kind = moveKind(undo.move);
+
+    removePiece(Us, kind == PROMOTION ? promotionType(undo.move) : undo.moved, toSq);
+    putPiece(Us, undo.moved, fromSq);
+
+    if (kind == CASTLING) {
+        bool kingside = toSq > fromSq;
+        removePiece(Us, ROOK, Side::HOME + (kingside ? 5 : 3));
+        putPiece(Us, ROOK, Side::HOME + (kingside ? 7 : 0));
+    }
+
+    if (undo.captured != NO_PIECE_TYPE) {
+        putPiece(Side::THEM, undo.captured, (kind == EN_PASSANT) ? toSq - Side::UP : toSq);
+    }
+}
+
+void Board::undoMove(const UndoInfo& undo) {
+    isWhiteTurn = !isWhiteTurn;
+    if (isWhiteTurn) {
+        restorePieces<WHITE>(undo);
+    } else {
+        restorePieces<BLACK>(undo);
+    }
+
+    castlingRights = undo.castlingRights;
+    enPassantSquare = undo.enPassantSquare;
+    lastMove[0] = undo.lastMove[0];
+    lastMove[1] = undo.lastMove[1];
+    key = undo.key;
+    halfmoveClock = undo.halfmoveClock;
+    fullmoveNumber = undo.fullmoveNumber;
+}
+
+template<Color Us>
+Board::CheckInfo Board::checkInfo() const {
+    constexpr Color them = SideConstants<Us>::THEM;
+    CheckInfo info{0, ~0ULL, 0};
+    if (!pieces[Us][KING]) {
+        return info;
+    }
+    int king = kingSquare[Us];
+
+    info.checkers = attackersTo(king, allPieces) & occupied[them];
+    if (info.checkers) {
+        info.evasions = (info.checkers & (info.checkers - 1))
+                            ? 0
+                            : info.checkers | betweenSquares(king, lsb(info.checkers));
+    }
+
+    // Enemy sliders lined up with the king behind exactly one of our pieces
+    Bitboard snipers = (rookAttacks(king, 0) & (pieces[them][ROOK] | pieces[them][QUEEN])) |
+                       (bishopAttacks(king, 0) & (pieces[them][BISHOP] | pieces[them][QUEEN]));
+    while (snipers) {
+        Bitboard blockers = betweenSquares(king, popLsb(snipers)) & allPieces;
+        if (blockers && !(blockers & (blockers - 1))) {
+            info.pinned |= blockers & occupied[Us];
+        }
+    }
+    return info;
+}
+
+Board::CheckInfo Board::checkInfo(Color us) const {
+    return (us == WHITE) ? checkInfo<WHITE>() : checkInfo<BLACK>();
+}
+
+template<Color Us>
+bool Board::isLegalEnPassant(int from) const {
+    if (!pieces[Us][KING]) {
+        return true;
+    }
+    int captured = enPassantSquare - SideConstants<Us>::UP;
+    Bitboard after = (allPieces ^ squareBB(from) ^ squareBB(captured)) | squareBB(enPassantSquare);
+    return !(attackersTo(kingSquare[Us], after) & occupied[SideConstants<Us>::THEM] & ~squareBB(captured));
+}
+
+template<Color Us>
+Bitboard Board::safeKingTargets(Bitboard targets) const {
+    // Without the king on the board a slider checking along a line also
+    // covers the square behind it
+    Bitboard occupancy = allPieces ^ squareBB(kingSquare[Us]);
+    Bitboard safe = 0;
+    while (targets) {
+        int to = popLsb(targets);
+        if (!(attackersTo(to, occupancy) & occupied[SideConstants<Us>::THEM])) {
+            safe |= squareBB(to);
+        }
+    }
+    return safe;
+}
+
+Bitboard Board::legalTargets(int from, Color us, const CheckInfo& info) const {
+    Bitboard targets = pseudoMoves(from);
+    int king = kingSquare[us];
+
+    if (pieces[us][KING] & squareBB(from)) {
+        return (us == WHITE) ? safeKingTargets<WHITE>(targets) : safeKingTargets<BLACK>(targets);
+    }
+
+    Bitboard enPassant = 0;
+    if (enPassantSquare != NO_SQUARE && (targets & squareBB(enPassantSquare)) && pieceTypeAt(from) == PAWN) {
+        targets &= ~squareBB(enPassantSquare);
+        if ((us == WHITE) ? isLegalEnPassant<WHITE>(from) : isLegalEnPassant<BLACK>(from)) {
+            enPassant = squareBB(enPassantSquare);
+        }
+    }
+
+    targets &= info.evasions;
+    if (info.pinned & squareBB(from)) {
+        targets &= lineThrough(king, from);
+    }
+    return targets | enPassant;
+}
+
+// Pushes and captures of a set of pawns, landing only on `allowed` squares.
+// Pawns are moved as a whole set, one shift per direction.
+template<Color Us>
+void Board::addPawnMoves(Bitboard pawns, Bitboard allowed, MoveList& moves, MoveGenType genType) const {
+    using Side = SideConstants<Us>;
+    constexpr int up = Side::UP;
+    constexpr int upWest = Side::UP - 1;  // Capturing toward the a-file
+    constexpr int upEast = Side::UP + 1;
+    constexpr Bitboard promotionRank = Side::PROMOTION_RANK;
+
+    Bitboard empty = ~allPieces;
+    Bitboard enemies = occupied[Side::THEM];
+    Bitboard single = shiftBy<up>(pawns) & empty;
+    Bitboard twice = shiftBy<up>(single & Side::THIRD_RANK) & empty & allowed;
+    single &= allowed;
+    Bitboard west = shiftBy<upWest>(pawns & ~FILE_A) & enemies & allowed;
+    Bitboard east = shiftBy<upEast>(pawns & ~FILE_H) & enemies & allowed;
+
+    auto add = [&moves](Bitboard targets, int offset) {
+        while (targets) {
+            int to = popLsb(targets);
+            moves.add(encodeMove(to - offset, to));
+        }
+    };
+    auto addPromotions = [&moves](Bitboard targets, int offset) {
+        while (targets) {
+            int to = popLsb(targets);
+            for (int promotion = QUEEN; promotion >= KNIGHT; promotion--) {
+                moves.add(encodeMove(to - offset, to, PROMOTION, static_cast<PieceType>(promotion)));
             }
         }
-        if (kingPos.row != -1) break;
+    };
+
+    // Captures include every promotion
+    if (genType != GEN_QUIETS) {
+        addPromotions(west & promotionRank, upWest);
+        addPromotions(east & promotionRank, upEast);
+        addPromotions(single & promotionRank, up);
+        add(west & ~promotionRank, upWest);
+        add(east & ~promotionRank, upEast);
+    }
+    if (genType != GEN_CAPTURES) {
+        add(single & ~promotionRank, up);
+        add(twice, 2 * up);
     }
+}
 
-    // Check if any opponent piece can capture the king
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            const Piece* piece = board[i][j].get();
-            if (piece && piece->isWhite() != isWhite) {
-                Position from{i, j};
-                if (piece->isValidMove(from, kingPos, *this) && isPathClear(from, kingPos)) {
-                    return true;
+template<Color Us>
+void Board::generateMoves(MoveList& moves, MoveGenType genType) const {
+    using Side = SideConstants<Us>;
+    constexpr Color them = Side::THEM;
+    CheckInfo info = checkInfo<Us>();
+    int king = kingSquare[Us];
+
+    // Captures land on enemy pieces, quiet moves on empty squares
+    Bitboard targets = (genType == GEN_CAPTURES) ? occupied[them]
+                     : (genType == GEN_QUIETS)   ? ~allPieces
+                                                 : ~occupied[Us];
+
+    // In double check only the king can move
+    if (!(info.checkers & (info.checkers - 1))) {
+        Bitboard pawns = pieces[Us][PAWN];
+        addPawnMoves<Us>(pawns & ~info.pinned, info.evasions, moves, genType);
+        Bitboard pinnedPawns = pawns & info.pinned;
+        while (pinnedPawns) {
+            int from = popLsb(pinnedPawns);
+            addPawnMoves<Us>(squareBB(from), info.evasions & lineThrough(king, from), moves, genType);
+        }
+
+        // En passant ignores the masks and is checked on its own
+        if (genType != GEN_QUIETS && enPassantSquare != NO_SQUARE && isWhiteTurn == (Us == WHITE)) {
+            Bitboard capturers = pawnAttacks(them, enPassantSquare) & pawns;
+            while (capturers) {
+                int from = popLsb(capturers);
+                if (isLegalEnPassant<Us>(from)) {
+                    moves.add(encodeMove(from, enPassantSquare, EN_PASSANT));
                 }
             }
         }
+
+        auto addPieceMoves = [&](Bitboard set, auto attacks) {
+            while (set) {
+                int from = popLsb(set);
+                Bitboard reach = attacks(from) & targets & info.evasions;
+                if (info.pinned & squareBB(from)) {
+                    reach &= lineThrough(king, from);
+                }
+                while (reach) {
+                    moves.add(encodeMove(from, popLsb(reach)));
+                }
+            }
+        };
+        Bitboard occupancy = allPieces;
+        addPieceMoves(pieces[Us][KNIGHT], [](int sq) { return knightAttacks(sq); });
+        addPieceMoves(pieces[Us][BISHOP], [occupancy](int sq) { return bishopAttacks(sq, occupancy); });
+        addPieceMoves(pieces[Us][ROOK], [occupancy](int sq) { return rookAttacks(sq, occupancy); });
+        addPieceMoves(pieces[Us][QUEEN], [occupancy](int sq) { return queenAttacks(sq, occupancy); });
+    }
+
+    if (!pieces[Us][KING]) {
+        return;
+    }
+
+    Bitboard reach = safeKingTargets<Us>(kingAttacks(king) & targets);
+    while (reach) {
+        moves.add(encodeMove(king, popLsb(reach)));
+    }
+
+    if (genType != GEN_CAPTURES && !info.checkers) {
+        if (canCastleSide<Us>(true)) moves.add(encodeMove(king, Side::HOME + 6, CASTLING));
+        if (canCastleSide<Us>(false)) moves.add(encodeMove(king, Side::HOME + 2, CASTLING));
     }
-    return false;
 }
 
-bool Board::wouldBeInCheck(const Position& from, const Position& to, bool isWhite) const {
-    // Create a temporary board to simulate the move
-    Board tempBoard = *this;
-    tempBoard.movePiece(from, to);
-    return tempBoard.isInCheck(isWhite);
+void Board::generateLegalMoves(Color side, MoveList& moves, MoveGenType genType) const {
+    if (side == WHITE) {
+        generateMoves<WHITE>(moves, genType);
+    } else {
+        generateMoves<BLACK>(moves, genType);
+    }
 }
 
-bool Board::canCastle(const Position& from, const Position& to) const {
-    const King* king = dynamic_cast<const King*>(board[from.row][from.col].get());
-    if (!king || king->hasMoved()) {
-        return false;
+Move Board::moveFromString(const std::string& str) const {
+    MoveList moves;
+    generateLegalMoves(isWhiteTurn ? WHITE : BLACK, moves);
+    for (Move move : moves) {
+        if (moveToString(move) == str) {
+            return move;
+        }
     }
+    return NO_MOVE;
+}
 
-    int rookCol = (to.col > from.col) ? 7 : 0;
-    const Rook* rook = dynamic_cast<const Rook*>(board[from.row][rookCol].get());
-    if (!rook || rook->hasMoved()) {
+// The king and rook are on their home squares with the right still held,
+// the squares between them are empty and the king neither starts, passes
+// nor lands on an attacked square
+template<Color Us>
+bool Board::canCastleSide(bool kingside) const {
+    using Side = SideConstants<Us>;
+    int right = kingside ? (Us == WHITE ? WHITE_KINGSIDE : BLACK_KINGSIDE)
+                         : (Us == WHITE ? WHITE_QUEENSIDE : BLACK_QUEENSIDE);
+    int king = Side::HOME + 4;
+    int rook = Side::HOME + (kingside ? 7 : 0);
+    int target = Side::HOME + (kingside ? 6 : 2);
+    if (!(castlingRights & right) || !(pieces[Us][KING] & squareBB(king)) || !(pieces[Us][ROOK] & squareBB(rook))) {
         return false;
     }
 
-    // Check if path is clear and king is not in check during castling
-    if (isInCheck(king->isWhite())) {
+    if (betweenSquares(king, rook) & allPieces) {
         return false;
     }
+    Bitboard kingPath = betweenSquares(king, target) | squareBB(king) | squareBB(target);
+    while (kingPath) {
+        if (isSquareAttacked(popLsb(kingPath), Side::THEM)) return false;
+    }
+    return true;
+}
 
-    int step = (to.col > from.col) ? 1 : -1;
-    for (int col = from.col + step; col != rookCol; col += step) {
-        if (board[from.row][col] != nullptr) {
-            return false;
-        }
-        Position intermediate{from.row, col};
-        if (wouldBeInCheck(from, intermediate, king->isWhite())) {
-            return false;
-        }
+bool Board::canCastle(const Position& from, const Position& to) const {
+    if (!isValidPosition(from) || !isValidPosition(to) || from.row != to.row || from.col != 4 ||
+        (to.col != 6 && to.col != 2)) {
+        return false;
     }
 
-    return true;
+    Bitboard king = squareBB(makeSquare(from.row, from.col));
+    bool kingside = to.col == 6;
+    if (pieces[WHITE][KING] & king) return canCastleSide<WHITE>(kingside);
+    if (pieces[BLACK][KING] & king) return canCastleSide<BLACK>(kingside);
+    return false;
 }
 
 bool Board::isEnPassantMove(const Position& from, const Position& to) const {
-    const Pawn* pawn = dynamic_cast<const Pawn*>(board[from.row][from.col].get());
-    if (!pawn) return false;
+    if (!isValidPosition(from) || !isValidPosition(to) || enPassantSquare == NO_SQUARE) {
+        return false;
+    }
 
-    // Check if the last move was a two-square pawn advance
-    const Position& lastFrom = lastMove[0];
-    const Position& lastTo = lastMove[1];
-    const Piece* lastPiece = board[lastTo.row][lastTo.col].get();
+    int fromSq = makeSquare(from.row, from.col);
+    bool white = (pieces[WHITE][PAWN] & squareBB(fromSq)) != 0;
+    if (!white && !(pieces[BLACK][PAWN] & squareBB(fromSq))) return false;
 
-    return lastPiece && dynamic_cast<const Pawn*>(lastPiece) &&
-           abs(lastTo.row - lastFrom.row) == 2 &&
-           lastTo.col == to.col &&
+    return makeSquare(to.row, to.col) == enPassantSquare &&
            abs(from.col - to.col) == 1 &&
-           ((pawn->isWhite() && from.row == 4) || (!pawn->isWhite() && from.row == 3));
+           ((white && from.row == 4) || (!white && from.row == 3));
 }
 
 void Board::promotePawn(const Position& pos, char promotionPiece) {
-    if (!isValidPosition(pos) || !board[pos.row][pos.col]) {
+    if (!isValidPosition(pos)) {
         return;
     }
 
-    const Pawn* pawn = dynamic_cast<Pawn*>(board[pos.row][pos.col].get());
-    if (!pawn) {
+    int sq = makeSquare(pos.row, pos.col);
+    if (pieceTypeAt(sq) != PAWN) {
         return;
     }
 
-    bool isWhite = pawn->isWhite();
+    Color color = (occupied[WHITE] & squareBB(sq)) ? WHITE : BLACK;
+    PieceType type;
     switch (promotionPiece) {
-        case 'Q': board[pos.row][pos.col] = std::make_unique<Queen>(isWhite); break;
-        case 'R': board[pos.row][pos.col] = std::make_unique<Rook>(isWhite); break;
-        case 'B': board[pos.row][pos.col] = std::make_unique<Bishop>(isWhite); break;
-        case 'N': board[pos.row][pos.col] = std::make_unique<Knight>(isWhite); break;
-        default: board[pos.row][pos.col] = std::make_unique<Queen>(isWhite); break;
+        case 'Q': type = QUEEN; break;
+        case 'R': type = ROOK; break;
+        case 'B': type = BISHOP; break;
+        case 'N': type = KNIGHT; break;
+        default: type = QUEEN; break;
     }
+    removePiece(color, PAWN, sq);
+    putPiece(color, type, sq);
 }
 
 const Piece* Board::getPiece(const Position& pos) const {
     if (!isValidPosition(pos)) {
         return nullptr;
     }
-    return board[pos.row][pos.col].get();
+    const Piece& piece = squares[makeSquare(pos.row, pos.col)];
+    return piece.isEmpty() ? nullptr : &piece;
 }
 
 std::vector<Position> Board::getValidMoves(const Position& pos) const {
+    STAT_SCOPE(STAT_GET_VALID_MOVES);
     std::vector<Position> validMoves;
-    if (!isValidPosition(pos) || !board[pos.row][pos.col]) {
+    const Piece* piece = getPiece(pos);
+    if (!piece || piece->isWhite() != isWhiteTurn) {
         return validMoves;
     }
 
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            Position to{i, j};
-            if (isValidMove(pos, to)) {
-                validMoves.push_back(to);
-            }
+    MoveList moves;
+    generateLegalMoves(isWhiteTurn ? WHITE : BLACK, moves);
+
+    int from = makeSquare(pos.row, pos.col);
+    for (Move move : moves) {
+        // Promotions to each piece share a destination; report it once
+        if (moveFrom(move) != from ||
+            (moveKind(move) == PROMOTION && promotionType(move) != QUEEN)) {
+            continue;
         }
+        validMoves.push_back(Position(rowOf(moveTo(move)), colOf(moveTo(move))));
     }
     return validMoves;
 }
 
 std::string Board::toString() const {
     std::stringstream ss;
-    printf("\n");
+    ss << "\n";
     const std::string files = "  a   b   c   d   e   f   g   h";
 
     auto printBorder = [&]() {
@@ -282,11 +765,11 @@ std::string Board::toString() const {
     for (int i = BOARD_SIZE - 1; i >= 0; i--) {
         ss << (i + 1) << " |";
         for (int j = 0; j < BOARD_SIZE; j++) {
-            const Piece* piece = board[i][j].get();
+            const Piece* piece = getPiece(Position(i, j));
             char symbol = ' ';
             if (piece) {
                 char p = piece->getSymbol();
-                symbol = piece->isWhite() ? static_cast<char>(toupper(p)) 
+                symbol = piece->isWhite() ? static_cast<char>(toupper(p))
                                           : static_cast<char>(tolower(p));
             } else {
                 symbol = '.';
@@ -302,44 +785,206 @@ std::string Board::toString() const {
     return ss.str();
 }
 
-bool Board::isCheckmate(bool isWhite) const {
-    if (!isInCheck(isWhite)) {
-        return false;
+void Board::setPosition(const PiecePlacement* placements, int count, bool whiteToMove,
+                        int castling, int enPassant, int halfmoves, int fullmoves) {
+    clear();
+    for (int i = 0; i < count; i++) {
+        putPiece(placements[i].color, placements[i].type, placements[i].square);
     }
+    isWhiteTurn = whiteToMove;
+    castlingRights = castling;
+    enPassantSquare = enPassant;
+    halfmoveClock = halfmoves;
+    fullmoveNumber = fullmoves;
+    key = computeHash();
+}
 
-    // Check if any move can get out of check
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            const Piece* piece = board[i][j].get();
-            if (piece && piece->isWhite() == isWhite) {
-                Position from{i, j};
-                std::vector<Position> moves = getValidMoves(from);
-                if (!moves.empty()) {
-                    return false;
-                }
+bool Board::fromFEN(std::string_view fen) {
+    clear();
+    size_t i = 0;
+    auto skipSpaces = [&]() { while (i < fen.size() && fen[i] == ' ') i++; };
+    auto fail = [this]() { clear(); return false; };
+
+    // Piece placement, rank 8 first
+    int row = 7;
+    int col = 0;
+    for (; i < fen.size() && fen[i] != ' '; i++) {
+        char c = fen[i];
+        if (c == '/') {
+            if (col != 8 || row == 0) return fail();
+            row--;
+            col = 0;
+        } else if (c >= '1' && c <= '8') {
+            col += c - '0';
+            if (col > 8) return fail();
+        } else {
+            PieceType type;
+            switch (tolower(static_cast<unsigned char>(c))) {
+                case 'p': type = PAWN; break;
+                case 'n': type = KNIGHT; break;
+                case 'b': type = BISHOP; break;
+                case 'r': type = ROOK; break;
+                case 'q': type = QUEEN; break;
+                case 'k': type = KING; break;
+                default: return fail();
             }
+            if (col >= 8) return fail();
+            putPiece(isupper(static_cast<unsigned char>(c)) ? WHITE : BLACK, type, makeSquare(row, col));
+            col++;
         }
     }
+    if (row != 0 || col != 8) return fail();
+    if (popCount(pieces[WHITE][KING]) != 1 || popCount(pieces[BLACK][KING]) != 1) return fail();
+
+    // Side to move
+    skipSpaces();
+    if (i >= fen.size() || (fen[i] != 'w' && fen[i] != 'b')) return fail();
+    isWhiteTurn = fen[i++] == 'w';
+
+    // The side that just moved cannot have left its king in check
+    if (isInCheck(!isWhiteTurn)) return fail();
+
+    // Castling rights
+    skipSpaces();
+    if (i < fen.size() && fen[i] == '-') {
+        i++;
+    } else {
+        for (; i < fen.size() && fen[i] != ' '; i++) {
+            switch (fen[i]) {
+                case 'K': castlingRights |= WHITE_KINGSIDE; break;
+                case 'Q': castlingRights |= WHITE_QUEENSIDE; break;
+                case 'k': castlingRights |= BLACK_KINGSIDE; break;
+                case 'q': castlingRights |= BLACK_QUEENSIDE; break;
+                default: return fail();
+            }
+        }
+    }
+
+    // En passant target square
+    skipSpaces();
+    if (i < fen.size() && fen[i] == '-') {
+        i++;
+    } else if (i + 1 < fen.size() && fen[i] >= 'a' && fen[i] <= 'h' && (fen[i + 1] == '3' || fen[i + 1] == '6')) {
+        int sq = makeSquare(fen[i + 1] - '1', fen[i] - 'a');
+        i += 2;
+
+        // Only keep a square a double push could just have skipped: on the
+        // mover's sixth rank, empty along with the square behind it, and
+        // with an enemy pawn in front. Anything else is dropped.
+        Color them = isWhiteTurn ? BLACK : WHITE;
+        int up = isWhiteTurn ? 8 : -8;
+        if (rowOf(sq) == (isWhiteTurn ? 5 : 2) &&
+            !(allPieces & (squareBB(sq) | squareBB(sq + up))) &&
+            (pieces[them][PAWN] & squareBB(sq - up))) {
+            enPassantSquare = sq;
+        }
+    } else {
+        return fail();
+    }
+
+    // Move clocks are optional
+    auto readNumber = [&](int& value) {
+        skipSpaces();
+        if (i >= fen.size() || fen[i] < '0' || fen[i] > '9') return false;
+        value = 0;
+        while (i < fen.size() && fen[i] >= '0' && fen[i] <= '9') {
+            value = value * 10 + (fen[i++] - '0');
+        }
+        return true;
+    };
+    if (readNumber(halfmoveClock)) {
+        readNumber(fullmoveNumber);
+    }
+    if (fullmoveNumber < 1) fullmoveNumber = 1;
+
+    key = computeHash();
     return true;
 }
 
+std::string Board::toFEN() const {
+    std::string fen;
+    fen.reserve(90);
+
+    for (int row = BOARD_SIZE - 1; row >= 0; row--) {
+        int empty = 0;
+        for (int col = 0; col < BOARD_SIZE; col++) {
+            int sq = makeSquare(row, col);
+            if (!(allPieces & squareBB(sq))) {
+                empty++;
+                continue;
+            }
+            if (empty) {
+                fen += static_cast<char>('0' + empty);
+                empty = 0;
+            }
+            char symbol = "pnbrqk"[pieceTypeAt(sq)];
+            fen += (occupied[WHITE] & squareBB(sq)) ? static_cast<char>(toupper(symbol)) : symbol;
+        }
+        if (empty) fen += static_cast<char>('0' + empty);
+        if (row > 0) fen += '/';
+    }
+
+    fen += isWhiteTurn ? " w " : " b ";
+    if (castlingRights) {
+        if (castlingRights & WHITE_KINGSIDE) fen += 'K';
+        if (castlingRights & WHITE_QUEENSIDE) fen += 'Q';
+        if (castlingRights & BLACK_KINGSIDE) fen += 'k';
+        if (castlingRights & BLACK_QUEENSIDE) fen += 'q';
+    } else {
+        fen += '-';
+    }
+
+    fen += ' ';
+    if (enPassantSquare != NO_SQUARE) {
+        fen += static_cast<char>('a' + colOf(enPassantSquare));
+        fen += static_cast<char>('1' + rowOf(enPassantSquare));
+    } else {
+        fen += '-';
+    }
+
+    fen += ' ';
+    fen += std::to_string(halfmoveClock);
+    fen += ' ';
+    fen += std::to_string(fullmoveNumber);
+    return fen;
+}
+
+GameStatus Board::status() const {
+    MoveList moves;
+    generateLegalMoves(isWhiteTurn ? WHITE : BLACK, moves);
+    if (!moves.empty()) {
+        return ONGOING;
+    }
+    return isInCheck(isWhiteTurn) ? CHECKMATE : STALEMATE;
+}
+
+bool Board::isCheckmate(bool isWhite) const {
+    STAT_SCOPE(STAT_IS_CHECKMATE);
+    if (isWhite == isWhiteTurn) {
+        return status() == CHECKMATE;
+    }
+
+    if (!isInCheck(isWhite)) {
+        return false;
+    }
+
+    // Check if any move can get out of check
+    MoveList moves;
+    generateLegalMoves(isWhite ? WHITE : BLACK, moves);
+    return moves.empty();
+}
+
 bool Board::isStalemate(bool isWhite) const {
+    if (isWhite == isWhiteTurn) {
+        return status() == STALEMATE;
+    }
+
     if (isInCheck(isWhite)) {
         return false;
     }
 
     // Check if any legal move exists
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            const Piece* piece = board[i][j].get();
-            if (piece && piece->isWhite() == isWhite) {
-                Position from{i, j};
-                std::vector<Position> moves = getValidMoves(from);
-                if (!moves.empty()) {
-                    return false;
-                }
-            }
-        }
-    }
-    return true;
-}
\ No newline at end of file
+    MoveList moves;
+    generateLegalMoves(isWhite ? WHITE : BLACK, moves);
+    return moves.empty();
+}
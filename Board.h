@@ -3,40 +3,156 @@
 
 #include "Piece.h"
 #include "position.h"
+#include "Bitboard.h"
+#include "Move.h"
+#include "Zobrist.h"
+#include "Psqt.h"
 #include <memory>
 #include <vector>
 #include <string>
+#include <string_view>
+
+const char* const START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Everything doMove changes that cannot be recomputed from the move itself.
+// Filled by doMove and handed back to undoMove; lives on the caller's stack.
+struct UndoInfo {
+    Move move;
+    PieceType moved;
+    PieceType captured;      // NO_PIECE_TYPE if the move captured nothing
+    int castlingRights;
+    int enPassantSquare;
+    Position lastMove[2];
+    uint64_t key;
+    int halfmoveClock;
+    int fullmoveNumber;
+};
+
+// Whether the side to move can still play on
+enum GameStatus { ONGOING, CHECKMATE, STALEMATE };
+
+// Which legal moves to generate
+enum MoveGenType { GEN_ALL, GEN_CAPTURES, GEN_QUIETS };
+
+// One piece for Board::setPosition
+struct PiecePlacement {
+    Color color;
+    PieceType type;
+    int square;
+};
 
 class Board {
+
 private:
     static const int BOARD_SIZE = 8;
-    std::unique_ptr<Piece> board[BOARD_SIZE][BOARD_SIZE];
-    
+
+    Bitboard pieces[2][6];   // One mask per color and piece type
+    Bitboard occupied[2];    // All pieces of each color
+    Bitboard allPieces;      // Union of both colors
+    Piece squares[64];       // Mailbox view of the same pieces, for lookups by square
+    int kingSquare[2];       // Kept current by putPiece
+
+    int castlingRights;
+    int enPassantSquare;     // Square a pawn may capture onto en passant, or NO_SQUARE
+    int halfmoveClock;       // Plies since the last capture or pawn move
+    int fullmoveNumber;      // Starts at 1, incremented after Black moves
+
     Position lastMove[2];  // Store last move's [from, to] positions for en passant
+    uint64_t key;          // Zobrist hash of the position, updated with every change
+
+    // Evaluation terms kept current by putPiece and removePiece
+    Score psqt;            // Material and piece-square score, White minus Black
+    int phase;             // Sum of PHASE_WEIGHT over the pieces on the board
+    uint64_t pawnKey;      // Zobrist hash of the pawns alone
+
+    void clear();
+    void putPiece(Color color, PieceType type, int sq);
+    void removePiece(Color color, PieceType type, int sq);
+    void switchSide();
+    Bitboard pseudoMoves(int from) const;
+    Move toMove(const Position& from, const Position& to, char promotionPiece) const;
+    void relocatePieces(Move move);
+    void saveUndo(Move move, UndoInfo& undo) const;
+
+    // What keeps one side's king safe, worked out once per position so that
+    // legal moves come straight out of the generator without trial moves
+    struct CheckInfo {
+        Bitboard checkers;   // Enemy pieces giving check
+        Bitboard evasions;   // Where a non-king move must land: anywhere when not in
+                             // check, onto the checker or between it and the king
+                             // for a single check, nowhere for a double check
+        Bitboard pinned;     // Own pieces that may only move along the line to their king
+    };
+    CheckInfo checkInfo(Color us) const;
+
+    // Legal destinations of the piece on `from`, castling aside
+    Bitboard legalTargets(int from, Color us, const CheckInfo& info) const;
 
-    bool isPathClear(const Position& from, const Position& to) const;
-    void movePiece(const Position& from, const Position& to);
-    bool wouldBeInCheck(const Position& from, const Position& to, bool isWhite) const;
+    // The per-move work, compiled once for each side so pawn directions,
+    // ranks and castling squares are constants. The public entry points pick
+    // the side once and call these.
+    template<Color Us> Bitboard computeAttacks() const;
+    template<Color Us> void relocatePieces(Move move);
+    template<Color Us> void restorePieces(const UndoInfo& undo);
+    template<Color Us> CheckInfo checkInfo() const;
+    template<Color Us> void generateMoves(MoveList& moves, MoveGenType genType) const;
+    template<Color Us> void addPawnMoves(Bitboard pawns, Bitboard allowed, MoveList& moves,
+                                         MoveGenType genType) const;
+    template<Color Us> bool canCastleSide(bool kingside) const;
+
+    // An en passant capture takes two pieces off one rank, so it is checked
+    // against the position it leaves behind
+    template<Color Us> bool isLegalEnPassant(int from) const;
+
+    // The squares of `targets` the king can step to without being attacked
+    template<Color Us> Bitboard safeKingTargets(Bitboard targets) const;
 
 public:
+    // Castling rights flags
+    enum {
+        WHITE_KINGSIDE = 1,
+        WHITE_QUEENSIDE = 2,
+        BLACK_KINGSIDE = 4,
+        BLACK_QUEENSIDE = 8
+    };
+
     bool isWhiteTurn;
 
     Board();
-    Board(const Board& other);
+    Board(const Board& other) = default;
     ~Board() = default;
 
-    // Disable copying to prevent multiple boards
-    // Board(const Board&) = delete;
-    // Board& operator=(const Board&) = delete;
-
     bool isValidPosition(const Position& pos) const;
 
     // Core game functions
-    bool makeMove(const Position& from, const Position& to);
+    bool makeMove(const Position& from, const Position& to, char promotionPiece = 'Q');
     bool isValidMove(const Position& from, const Position& to) const;
     bool isInCheck(bool isWhite) const;
     bool isCheckmate(bool isWhite) const;
     bool isStalemate(bool isWhite) const;
+    GameStatus status() const;  // Generates the legal moves on each call
+    bool isSquareAttacked(int sq, Color by) const;
+
+    // Pieces of both colors attacking a square, with sliders seen through
+    // the given occupancy
+    Bitboard attackersTo(int sq, Bitboard occupancy) const;
+
+    // Apply a move in place without validating it, and take it back again.
+    // Moves must be undone in reverse order.
+    void doMove(Move move, UndoInfo& undo);
+    void doMove(const Position& from, const Position& to, UndoInfo& undo);
+    void undoMove(const UndoInfo& undo);
+
+    // Every legal move for one side, normally the side to move. GEN_CAPTURES
+    // limits it to captures and promotions, GEN_QUIETS to everything else.
+    void generateLegalMoves(Color side, MoveList& moves, MoveGenType genType = GEN_ALL) const;
+
+    // Whether a move from elsewhere (a hash table, a killer slot) can be
+    // played in this position
+    bool isLegalMove(Move move) const;
+
+    // The legal move written in coordinate notation ("e2e4", "e7e8q"), or NO_MOVE
+    Move moveFromString(const std::string& str) const;
 
     // Special moves
     bool canCastle(const Position& from, const Position& to) const;
@@ -46,10 +162,45 @@ public:
     // Getters
     const Piece* getPiece(const Position& pos) const;
     bool isWhitesTurn() const { return isWhiteTurn; }
+    uint64_t hash() const { return key; }
+    uint64_t computeHash() const;
     std::vector<Position> getValidMoves(const Position& pos) const;
 
+    // Piece kind on a square, or NO_PIECE_TYPE if it is empty
+    PieceType pieceTypeAt(int sq) const;
+    bool isCapture(Move move) const;
+
+    // Bitboard access
+    Bitboard piecesOf(Color color, PieceType type) const { return pieces[color][type]; }
+    Bitboard occupancy(Color color) const { return occupied[color]; }
+    Bitboard occupancy() const { return allPieces; }
+    Bitboard attackedSquares(Color side) const;  // Computed on each call
+    int getKingSquare(Color color) const { return kingSquare[color]; }
+
+    Score psqtScore() const { return psqt; }
+    int gamePhase() const { return phase; }
+    uint64_t pawnHash() const { return pawnKey; }
+
+    int getCastlingRights() const { return castlingRights; }
+    int getEnPassantSquare() const { return enPassantSquare; }
+    int getHalfmoveClock() const { return halfmoveClock; }
+    int getFullmoveNumber() const { return fullmoveNumber; }
+
     // Board representation
     std::string toString() const;
+
+    // Forsyth-Edwards Notation. fromFEN replaces the whole position and
+    // returns false (leaving the board empty) if the text is malformed. An
+    // en passant square no double push could have produced is ignored.
+    bool fromFEN(std::string_view fen);
+    std::string toFEN() const;
+
+    // Replace the whole position with these pieces and the given rights and
+    // clocks. Much cheaper than building a FEN string when positions are
+    // enumerated (tablebase generation) or unpacked from a compact record
+    // (the game server). The pieces must not share squares.
+    void setPosition(const PiecePlacement* placements, int count, bool whiteToMove,
+                     int castling = 0, int enPassant = NO_SQUARE, int halfmoves = 0, int fullmoves = 1);
 };
 
-#endif // BOARD_H
\ No newline at end of file
+#endif // BOARD_H
@@ -0,0 +1,46 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include "Board.h"
+#include "MappedFile.h"
+#include "Move.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Position key in the Polyglot book layout: one random number per piece on
+// each square, per castling right, per en passant file (only when a pawn
+// can actually capture there) and for White to move
+uint64_t polyglotKey(const Board& board);
+
+struct BookMove {
+    Move move;
+    int weight;
+};
+
+// Polyglot .bin opening book: 16-byte big-endian entries (key, move, weight,
+// learn) sorted by key. The file is memory-mapped and searched in place, so
+// one book can be shared by any number of threads and games.
+class OpeningBook {
+public:
+    bool open(const std::string& path);
+    void close() { file.close(); }
+    bool isOpen() const { return file.isOpen(); }
+
+    // Legal book moves for the position with their weights
+    std::vector<BookMove> lookup(const Board& board) const;
+
+    // A book move chosen with probability proportional to its weight, or the
+    // heaviest one when `best` is set. NO_MOVE when the position is not in
+    // the book.
+    Move pickMove(const Board& board, bool best = false) const;
+
+private:
+    MappedFile file;
+    size_t entryCount = 0;
+};
+
+// Command line entry: makebook <pgn> <book.bin> [max plies]
+int runMakeBook(int argc, char* argv[]);
+
+#endif // BOOK_H
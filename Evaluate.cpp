@@ -0,0 +1,84 @@
+#include "Evaluate.h"
+#include <algorithm>
+
+// Pawn structure terms, per pawn
+static const Score DOUBLED_PAWN = { -10, -20 };
+static const Score ISOLATED_PAWN = { -10, -15 };
+static const Score PASSED_PAWN[8] = {  // By rank from the pawn's own side
+    {0, 0}, {5, 10}, {10, 20}, {15, 35}, {25, 60}, {40, 90}, {60, 130}, {0, 0}
+};
+
+// Per attacked square not occupied by the side's own pieces
+static const Score MOBILITY = { 2, 1 };
+
+// Pawn structure only depends on the pawns, which rarely move, so results
+// are cached by the pawn-only hash. One table per search thread.
+struct PawnEntry {
+    uint64_t key;
+    Score score;
+};
+
+const int PAWN_TABLE_SIZE = 16384;  // Power of two
+static thread_local PawnEntry pawnTable[PAWN_TABLE_SIZE];
+
+static Bitboard fileMask(int col) {
+    return FILE_A << col;
+}
+
+// Pawn structure from White's point of view
+static Score evaluatePawns(const Board& board) {
+    Score score = { 0, 0 };
+    for (int c = 0; c < 2; c++) {
+        Color us = static_cast<Color>(c);
+        Bitboard own = board.piecesOf(us, PAWN);
+        Bitboard theirs = board.piecesOf(!us, PAWN);
+        Score side = { 0, 0 };
+
+        for (int col = 0; col < 8; col++) {
+            int count = popCount(own & fileMask(col));
+            if (count > 1) side += DOUBLED_PAWN * (count - 1);
+        }
+
+        Bitboard pawns = own;
+        while (pawns) {
+            int sq = popLsb(pawns);
+            int row = rowOf(sq);
+            int col = colOf(sq);
+            Bitboard adjacent = (col > 0 ? fileMask(col - 1) : 0) | (col < 7 ? fileMask(col + 1) : 0);
+            if (!(own & adjacent)) side += ISOLATED_PAWN;
+
+            // Passed: no enemy pawn ahead on its own or a neighbouring file
+            Bitboard ahead = (us == WHITE) ? ~0ULL << (8 * (row + 1)) : (1ULL << (8 * row)) - 1;
+            if (!(theirs & ahead & (adjacent | fileMask(col)))) {
+                side += PASSED_PAWN[(us == WHITE) ? row : 7 - row];
+            }
+        }
+        score += (us == WHITE) ? side : -side;
+    }
+    return score;
+}
+
+static Score pawnStructure(const Board& board) {
+    PawnEntry& entry = pawnTable[board.pawnHash() & (PAWN_TABLE_SIZE - 1)];
+    if (entry.key != board.pawnHash()) {
+        entry.key = board.pawnHash();
+        entry.score = evaluatePawns(board);
+    }
+    return entry.score;
+}
+
+int evaluate(const Board& board) {
+    // Material and piece-square terms are maintained by the board as pieces move
+    Score score = board.psqtScore() + pawnStructure(board);
+
+    // Mobility: squares each side attacks that it does not occupy
+    int mobility = popCount(board.attackedSquares(WHITE) & ~board.occupancy(WHITE)) -
+                   popCount(board.attackedSquares(BLACK) & ~board.occupancy(BLACK));
+    score += MOBILITY * mobility;
+
+    // Blend by phase: all middlegame with every piece on, all endgame with
+    // only kings and pawns
+    int phase = std::min(board.gamePhase(), MAX_PHASE);
+    int value = (score.mg * phase + score.eg * (MAX_PHASE - phase)) / MAX_PHASE;
+    return board.isWhiteTurn ? value : -value;
+}
@@ -0,0 +1,15 @@
+#ifndef EVALUATE_H
+#define EVALUATE_H
+
+#include "Board.h"
+
+// Material values in centipawns, indexed by PieceType, for move ordering and
+// exchange evaluation
+const int PIECE_VALUES[6] = { 100, 320, 330, 500, 900, 0 };
+
+// Static evaluation in centipawns from the point of view of the side to move:
+// material and piece-square tables, pawn structure and mobility, each with a
+// middlegame and an endgame value blended by the material left on the board
+int evaluate(const Board& board);
+
+#endif // EVALUATE_H
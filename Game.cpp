@@ -1,15 +1,24 @@
 #include "Game.h"
+#include "Stats.h"
+#include "Tablebase.h"
 #include <iostream>
 #include <cctype>
 #include <string>
 
-Game::Game() {}
+Game::Game() : hasComputer(false), computerIsWhite(false), adjudicate(false),
+               status(board.status()) {}
 
 void Game::play() {
     std::string moveStr;
     displayBoard();
 
     while (!isGameOver()) {
+        if (isComputerTurn()) {
+            executeComputerMove();
+            displayBoard();
+            continue;
+        }
+
         std::cout << (board.isWhiteTurn ? "White" : "Black") << "'s turn.\n";
         std::cout << "Enter move (e.g., e2e4): ";
         std::getline(std::cin, moveStr);
@@ -18,6 +27,11 @@ void Game::play() {
             break;
         }
 
+        if (moveStr == "stats") {
+            printStats(std::cout);
+            continue;
+        }
+
         if (!makeMove(moveStr)) {
             std::cout << "Invalid move! Try again.\n";
             continue;
@@ -39,8 +53,13 @@ void Game::displayBoard() const {
 
 bool Game::executePlayerMove() {
     std::string move;
-    std::cout << "Enter move (e.g. e2e4): ";
+    std::cout << "Enter move (e.g. e2e4, or stats): ";
     std::cin >> move;
+    while (move == "stats") {
+        printStats(std::cout);
+        std::cout << "Enter move (e.g. e2e4): ";
+        if (!(std::cin >> move)) return false;
+    }
     
     if (move.length() != 4) {
         return false;
@@ -51,7 +70,44 @@ bool Game::executePlayerMove() {
     Position to(move[3] - '1', move[2] - 'a');
     
     // Try to execute the move
-    return board.makeMove(from, to);
+    return playMove(from, to);
+}
+
+void Game::setComputerPlayer(bool playsWhite, const SearchLimits& limits) {
+    hasComputer = true;
+    computerIsWhite = playsWhite;
+    computerLimits = limits;
+}
+
+bool Game::setTablebases(const std::string& directory) {
+    adjudicate = tablebases.load(directory) > 0;
+    return adjudicate;
+}
+
+bool Game::isComputerTurn() const {
+    return hasComputer && board.isWhiteTurn == computerIsWhite;
+}
+
+bool Game::executeComputerMove() {
+    Move move = book.pickMove(board);
+    if (move != NO_MOVE) {
+        std::cout << "Computer plays " << moveToString(move) << " (book)\n";
+    } else {
+        SearchResult result = search.think(board, computerLimits);
+        if (result.bestMove == NO_MOVE) {
+            return false;
+        }
+        move = result.bestMove;
+        std::cout << "Computer plays " << moveToString(move)
+                  << " (depth " << result.depth << ", score " << result.score
+                  << ", " << result.nodes << " nodes, " << result.nps() << " nps, "
+                  << static_cast<int>(result.firstMoveCutoffRate()) << "% first-move cutoffs)\n";
+    }
+
+    Position from(rowOf(moveFrom(move)), colOf(moveFrom(move)));
+    Position to(rowOf(moveTo(move)), colOf(moveTo(move)));
+    char promotion = (moveKind(move) == PROMOTION) ? "NBRQ"[promotionType(move) - KNIGHT] : 'Q';
+    return playMove(from, to, promotion);
 }
 
 bool Game::makeMove(const std::string& moveStr) {
@@ -64,28 +120,62 @@ bool Game::makeMove(const std::string& moveStr) {
         return false;
     }
 
-    return board.makeMove(from, to);
+    return playMove(from, to);
+}
+
+// Every move goes through here so the status is worked out once per position
+bool Game::playMove(const Position& from, const Position& to, char promotion) {
+    if (!board.makeMove(from, to, promotion)) {
+        return false;
+    }
+    status = board.status();
+    return true;
 }
 
 bool Game::isGameOver() const {
-    if (board.isCheckmate(board.isWhiteTurn)) { 
-        std::cout << (!board.isWhiteTurn ? "White" : "Black") << " wins by checkmate!" << std::endl; 
-        return true;
-    } else if (board.isStalemate(board.isWhiteTurn)) { 
-        std::cout << "Game ends in stalemate!" << std::endl; 
+    switch (status) {
+        case CHECKMATE:
+            std::cout << (!board.isWhiteTurn ? "White" : "Black") << " wins by checkmate!" << std::endl;
+            return true;
+        case STALEMATE:
+            std::cout << "Game ends in stalemate!" << std::endl;
+            return true;
+        default:
+            break;
+    }
+
+    std::string result = tablebaseResult();
+    if (!result.empty()) {
+        std::cout << result << std::endl;
         return true;
-    } 
+    }
     return false;
 }
 
 std::string Game::getGameResult() const {
-    if (board.isCheckmate(board.isWhiteTurn)) {
-        return (board.isWhiteTurn ? "Black" : "White") + std::string(" wins by checkmate!");
+    switch (status) {
+        case CHECKMATE:
+            return (board.isWhiteTurn ? "Black" : "White") + std::string(" wins by checkmate!");
+        case STALEMATE:
+            return "Game is drawn by stalemate.";
+        default: {
+            std::string result = tablebaseResult();
+            return result.empty() ? "Game in progress." : result;
+        }
+    }
+}
+
+std::string Game::tablebaseResult() const {
+    int wdl, plies;
+    if (!adjudicate || !tablebases.probe(board, wdl, plies)) {
+        return "";
     }
-    if (board.isStalemate(board.isWhiteTurn)) {
-        return "Game is drawn by stalemate.";
+    if (wdl == 0) {
+        return "Game is drawn according to the tablebases.";
     }
-    return "Game in progress.";
+    bool whiteWins = (wdl > 0) == board.isWhiteTurn;
+    return (whiteWins ? "White" : "Black") + std::string(" wins according to the tablebases (mate in ") +
+           std::to_string((plies + 1) / 2) + ").";
 }
 
 bool Game::parseMove(const std::string& moveStr, Position& from, Position& to) {
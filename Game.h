@@ -2,6 +2,8 @@
 #define GAME_H
 
 #include "Board.h"
+#include "Book.h"
+#include "Search.h"
 #include <string>
 
 class Game {
@@ -15,6 +17,19 @@ public:
     void displayBoard() const;
 
     bool executePlayerMove();
+
+    // Let the engine play one side, thinking within the given limits
+    void setComputerPlayer(bool playsWhite, const SearchLimits& limits);
+    void setEngineThreads(int threads) { search.setThreads(threads); }
+
+    // The computer plays from this Polyglot book while the position is in it
+    bool setOpeningBook(const std::string& path) { return book.open(path); }
+
+    // Load endgame tablebases for the engine's search and end the game as
+    // soon as the position is in one. False if the directory holds none.
+    bool setTablebases(const std::string& directory);
+    bool isComputerTurn() const;
+    bool executeComputerMove();
     
     // Process a move in algebraic notation (e.g., "e2e4")
     bool makeMove(const std::string& moveStr);
@@ -28,13 +43,25 @@ public:
     
  private:
     Board board;
+    Search search;
+    OpeningBook book;
+    bool hasComputer;
+    bool computerIsWhite;
+    SearchLimits computerLimits;
+    bool adjudicate;  // Stop at tablebase positions
+    GameStatus status;  // board.status(), refreshed after every move
     
     // Helper methods
+    bool playMove(const Position& from, const Position& to, char promotion = 'Q');
     bool parseMove(const std::string& moveStr, Position& from, Position& to);
     Position stringToPosition(const std::string& pos) const;
     std::string positionToString(const Position& pos) const;
     bool isValidMoveString(const std::string& moveStr) const;
     void handlePawnPromotion(const Position& pos);
+
+    // The tablebase result of the position, or an empty string when the
+    // game is not being adjudicated or no table covers it
+    std::string tablebaseResult() const;
     
     // Input validation
     bool isValidPositionString(const std::string& pos) const;
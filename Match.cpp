@@ -0,0 +1,399 @@
+#include "Match.h"
+#include "Pgn.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+static bool readPositiveNumber(const std::string& text, long& value) {
+    char* end = nullptr;
+    value = std::strtol(text.c_str(), &end, 10);
+    return !text.empty() && *end == '\0' && value > 0;
+}
+
+bool MatchEngine::parse(const std::string& spec, std::string& error) {
+    name = spec;
+    std::istringstream items(spec);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        size_t equals = item.find('=');
+        std::string key = item.substr(0, equals);
+        std::string value = (equals == std::string::npos) ? "" : item.substr(equals + 1);
+        long number = 0;
+        if (key == "nnue" && equals == std::string::npos) {
+            useNetwork = true;
+        } else if (key == "evalfile" && !value.empty()) {
+            networkFile = value;
+        } else if (key == "name" && !value.empty()) {
+            name = value;
+        } else if (key == "nodes" && readPositiveNumber(value, number)) {
+            limits.nodes = static_cast<uint64_t>(number);
+        } else if (key == "depth" && readPositiveNumber(value, number)) {
+            limits.depth = static_cast<int>(std::min<long>(number, MAX_PLY - 1));
+        } else if (key == "movetime" && readPositiveNumber(value, number)) {
+            limits.moveTime = static_cast<int>(number);
+        } else if (key == "hash" && readPositiveNumber(value, number)) {
+            hashMegabytes = static_cast<size_t>(number);
+        } else {
+            error = "bad engine setting '" + item + "'";
+            return false;
+        }
+    }
+    // Without any limit a move would take a full-depth search
+    if (limits.nodes == 0 && limits.moveTime == 0 && limits.depth == MAX_PLY - 1) {
+        limits.nodes = 20000;
+    }
+    return true;
+}
+
+// Expected score of the stronger side at a given Elo difference
+static double eloToScore(double elo) {
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+// Variance of a single game's score (1, 0.5 or 0) around the mean
+static double scoreVariance(const MatchScore& score) {
+    double n = static_cast<double>(score.games());
+    double mean = score.points() / n;
+    return (score.wins * (1 - mean) * (1 - mean) + score.draws * (0.5 - mean) * (0.5 - mean) +
+            score.losses * mean * mean) / n;
+}
+
+double MatchScore::elo() const {
+    if (games() == 0) return 0;
+    double p = points() / games();
+    if (p <= 0) return -std::numeric_limits<double>::infinity();
+    if (p >= 1) return std::numeric_limits<double>::infinity();
+    return 400.0 * std::log10(p / (1 - p));
+}
+
+double MatchScore::eloMargin() const {
+    if (games() == 0) return std::numeric_limits<double>::infinity();
+    double p = points() / games();
+    if (p <= 0 || p >= 1) return std::numeric_limits<double>::infinity();
+    // Standard error of the mean score, carried through the slope of the
+    // Elo curve at p
+    double error = std::sqrt(scoreVariance(*this) / games());
+    return 1.96 * error * 400.0 / (std::log(10.0) * p * (1 - p));
+}
+
+double MatchScore::llr(double elo0, double elo1) const {
+    if (games() == 0) return 0;
+    double variance = scoreVariance(*this);
+    if (variance <= 0) return 0;
+    double s0 = eloToScore(elo0);
+    double s1 = eloToScore(elo1);
+    return (s1 - s0) * (2 * points() - games() * (s0 + s1)) / (2 * variance);
+}
+
+double sprtLowerBound(double alpha, double beta) {
+    return std::log(beta / (1 - alpha));
+}
+
+double sprtUpperBound(double alpha, double beta) {
+    return std::log((1 - beta) / alpha);
+}
+
+namespace {
+
+const double SPRT_ALPHA = 0.05;
+const double SPRT_BETA = 0.05;
+
+struct PlayedGame {
+    std::string result;         // "1-0", "0-1" or "1/2-1/2"
+    std::string termination;
+    std::string movetext;
+};
+
+struct MatchState {
+    std::vector<Board> openings;
+    MatchEngine engines[2];
+    int games = 0;
+    int maxPlies = 400;
+    double elo0 = 0;
+    double elo1 = 5;
+
+    std::atomic<int> nextGame{0};
+    std::atomic<bool> stopped{false};
+
+    // Everything below is guarded by `mutex`
+    std::mutex mutex;
+    MatchScore score;
+    std::string decision;   // Set once the test has decided, with the games it took
+    uint64_t decisionGames = 0;
+    double decisionLlr = 0;
+};
+
+// Openings, one FEN or EPD record per line. EPD operations after the four
+// position fields are ignored; blank lines and lines starting with '#' are
+// skipped.
+bool readOpenings(const std::string& path, std::vector<Board>& openings) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Cannot open " << path << "\n";
+        return false;
+    }
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        std::istringstream fields(line);
+        std::string field, fen;
+        int count = 0;
+        while (fields >> field && (count < 4 || (count < 6 && std::isdigit(static_cast<unsigned char>(field[0]))))) {
+            fen += (count ? " " : "") + field;
+            count++;
+        }
+        if (count == 0 || fen[0] == '#') continue;
+
+        Board board;
+        if (count < 4 || !board.fromFEN(fen) || board.status() != ONGOING) {
+            std::cerr << path << ":" << lineNumber << ": not a playable position\n";
+            return false;
+        }
+        openings.push_back(board);
+    }
+    if (openings.empty()) {
+        std::cerr << "No openings in " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+// No sequence of legal moves can mate: bare kings, or one minor piece
+bool isInsufficientMaterial(const Board& board) {
+    Bitboard heavy = 0;
+    Bitboard minors = 0;
+    for (int c = 0; c < 2; c++) {
+        Color color = static_cast<Color>(c);
+        heavy |= board.piecesOf(color, PAWN) | board.piecesOf(color, ROOK) | board.piecesOf(color, QUEEN);
+        minors |= board.piecesOf(color, KNIGHT) | board.piecesOf(color, BISHOP);
+    }
+    return !heavy && popCount(minors) <= 1;
+}
+
+// The current position, the last entry of `keys`, has occurred three times
+// since the last capture or pawn move
+bool isThreefold(const std::vector<uint64_t>& keys, int halfmoveClock) {
+    int last = static_cast<int>(keys.size()) - 1;
+    int oldest = std::max(0, last - halfmoveClock);
+    int seen = 1;
+    for (int i = last - 2; i >= oldest; i -= 2) {
+        if (keys[i] == keys[last] && ++seen == 3) return true;
+    }
+    return false;
+}
+
+// Play one game; sides[0] and setups[0] are White
+PlayedGame playGame(const Board& opening, Search* sides[2], const MatchEngine* setups[2], int maxPlies) {
+    PlayedGame game;
+    Board board = opening;
+    std::vector<uint64_t> keys(1, board.hash());
+    std::ostringstream moves;
+    auto draw = [&game](const char* why) {
+        game.result = "1/2-1/2";
+        game.termination = why;
+    };
+
+    for (int ply = 0;; ply++) {
+        GameStatus status = board.status();
+        if (status == CHECKMATE) {
+            game.result = board.isWhiteTurn ? "0-1" : "1-0";
+            game.termination = board.isWhiteTurn ? "White is mated" : "Black is mated";
+            break;
+        }
+        if (status == STALEMATE) { draw("stalemate"); break; }
+        if (board.getHalfmoveClock() >= 100) { draw("fifty-move rule"); break; }
+        if (isThreefold(keys, board.getHalfmoveClock())) { draw("threefold repetition"); break; }
+        if (isInsufficientMaterial(board)) { draw("insufficient material"); break; }
+        if (ply >= maxPlies) { draw("move limit"); break; }
+
+        // The engines see the game so far, so they avoid or aim for the
+        // repetitions adjudicated above
+        int side = board.isWhiteTurn ? 0 : 1;
+        Move move = sides[side]->think(board, setups[side]->limits, nullptr, keys).bestMove;
+        if (move == NO_MOVE || !board.isLegalMove(move)) {
+            game.result = board.isWhiteTurn ? "0-1" : "1-0";
+            game.termination = std::string(board.isWhiteTurn ? "White" : "Black") + " played no legal move";
+            break;
+        }
+
+        if (board.isWhiteTurn || ply == 0) {
+            moves << board.getFullmoveNumber() << (board.isWhiteTurn ? ". " : "... ");
+        }
+        moves << moveToSan(board, move) << " ";
+        UndoInfo undo;
+        board.doMove(move, undo);
+        keys.push_back(board.hash());
+    }
+    moves << "{" << game.termination << "} " << game.result;
+    game.movetext = moves.str();
+    return game;
+}
+
+void printScore(std::ostream& out, const MatchState& state) {
+    const MatchScore& s = state.score;
+    out << std::fixed << std::setprecision(1) << "+" << s.wins << " -" << s.losses << " =" << s.draws
+        << "  Elo " << s.elo() << " +/- " << s.eloMargin() << std::setprecision(2) << "  LLR "
+        << s.llr(state.elo0, state.elo1) << " [" << sprtLowerBound(SPRT_ALPHA, SPRT_BETA) << ", "
+        << sprtUpperBound(SPRT_ALPHA, SPRT_BETA) << "]";
+    out.unsetf(std::ios::floatfield);
+}
+
+// Count a finished game, write its PGN and stop the match once the test
+// has decided
+void reportGame(MatchState& state, int index, bool firstIsWhite, const Board& opening, const PlayedGame& game) {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    MatchScore& score = state.score;
+    if (game.result == "1/2-1/2") score.draws++;
+    else if ((game.result == "1-0") == firstIsWhite) score.wins++;
+    else score.losses++;
+
+    const MatchEngine& white = state.engines[firstIsWhite ? 0 : 1];
+    const MatchEngine& black = state.engines[firstIsWhite ? 1 : 0];
+    std::cout << "[Event \"chess match\"]\n[Round \"" << (index + 1) << "\"]\n[White \"" << white.name
+              << "\"]\n[Black \"" << black.name << "\"]\n[Result \"" << game.result << "\"]\n";
+    std::string fen = opening.toFEN();
+    if (fen != START_FEN) {
+        std::cout << "[SetUp \"1\"]\n[FEN \"" << fen << "\"]\n";
+    }
+    std::cout << "\n" << game.movetext << "\n\n" << std::flush;
+
+    std::cerr << "Game " << (index + 1) << " " << game.result << " (" << game.termination << "), "
+              << state.engines[0].name << " vs " << state.engines[1].name << ": ";
+    printScore(std::cerr, state);
+    std::cerr << "\n";
+
+    double llr = score.llr(state.elo0, state.elo1);
+    if (state.decision.empty() && llr >= sprtUpperBound(SPRT_ALPHA, SPRT_BETA)) {
+        state.decision = "H1 accepted";
+    } else if (state.decision.empty() && llr <= sprtLowerBound(SPRT_ALPHA, SPRT_BETA)) {
+        state.decision = "H0 accepted";
+    }
+    if (!state.decision.empty() && !state.stopped) {
+        // Games already under way still finish and are counted
+        state.stopped = true;
+        state.decisionGames = score.games();
+        state.decisionLlr = llr;
+    }
+}
+
+// Each thread plays whole games with a search of its own for either engine.
+// Game 2k plays opening k with the first engine as White, game 2k+1 the
+// same opening with colors swapped.
+void playGames(MatchState& state) {
+    Search first(state.engines[0].hashMegabytes);
+    Search second(state.engines[1].hashMegabytes);
+    first.setUseNetwork(state.engines[0].useNetwork);
+    second.setUseNetwork(state.engines[1].useNetwork);
+
+    int index;
+    while (!state.stopped && (index = state.nextGame++) < state.games) {
+        const Board& opening = state.openings[(index / 2) % state.openings.size()];
+        bool firstIsWhite = (index % 2) == 0;
+        Search* sides[2] = { firstIsWhite ? &first : &second, firstIsWhite ? &second : &first };
+        const MatchEngine* setups[2] = { &state.engines[firstIsWhite ? 0 : 1], &state.engines[firstIsWhite ? 1 : 0] };
+        first.clearHash();
+        second.clearHash();
+        PlayedGame game = playGame(opening, sides, setups, state.maxPlies);
+        reportGame(state, index, firstIsWhite, opening, game);
+    }
+}
+
+}  // namespace
+
+int runMatch(int argc, char* argv[]) {
+    if (argc < 4) {
+        std::cerr << "Usage: chess match <openings.epd> <games> <engine A> <engine B>"
+                     " [threads n] [sprt elo0 elo1] [maxplies n]\n";
+        return 1;
+    }
+
+    MatchState state;
+    state.games = std::atoi(argv[1]);
+    std::string error;
+    if (state.games < 1) {
+        std::cerr << "Bad game count " << argv[1] << "\n";
+        return 1;
+    }
+    if (!state.engines[0].parse(argv[2], error) || !state.engines[1].parse(argv[3], error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    for (int i = 4; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "threads" && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (option == "sprt" && i + 2 < argc) {
+            state.elo0 = std::atof(argv[++i]);
+            state.elo1 = std::atof(argv[++i]);
+        } else if (option == "maxplies" && i + 1 < argc) {
+            state.maxPlies = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "Unknown option " << option << "\n";
+            return 1;
+        }
+    }
+    threads = std::max(1, std::min(threads, state.games));
+    if (state.elo1 <= state.elo0) {
+        std::cerr << "sprt needs elo0 < elo1\n";
+        return 1;
+    }
+
+    // There is one network for the whole process
+    std::string networkFile = state.engines[0].networkFile;
+    if (networkFile.empty()) networkFile = state.engines[1].networkFile;
+    if (!state.engines[1].networkFile.empty() && state.engines[1].networkFile != networkFile) {
+        std::cerr << "Both engines have to use the same evalfile\n";
+        return 1;
+    }
+    if (!networkFile.empty() && !nnueNetwork.load(networkFile)) {
+        std::cerr << "Cannot load network " << networkFile << "\n";
+        return 1;
+    }
+    if ((state.engines[0].useNetwork || state.engines[1].useNetwork) && !nnueNetwork.isLoaded()) {
+        std::cerr << "nnue needs evalfile=<path>\n";
+        return 1;
+    }
+
+    if (!readOpenings(argv[0], state.openings)) {
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; i++) {
+        pool.emplace_back(playGames, std::ref(state));
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const MatchScore& score = state.score;
+    std::cerr << "\n" << state.engines[0].name << " vs " << state.engines[1].name << ": " << score.games()
+              << " games in " << static_cast<long long>(seconds) << " s on " << threads << " threads, score "
+              << std::fixed << std::setprecision(3) << (score.games() ? score.points() / score.games() : 0.0)
+              << "\n";
+    printScore(std::cerr, state);
+    std::cerr << "\nSPRT elo0 " << std::fixed << std::setprecision(1) << state.elo0 << " elo1 " << state.elo1 << ": "
+              << (state.decision.empty() ? "inconclusive" : state.decision);
+    if (!state.decision.empty()) {
+        std::cerr << " after " << state.decisionGames << " games (LLR " << std::setprecision(2) << state.decisionLlr
+                  << ")";
+    }
+    std::cerr << "\n";
+    return 0;
+}
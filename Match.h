@@ -0,0 +1,56 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include "Search.h"
+#include <cstdint>
+#include <string>
+
+// One side of a match: how it searches. Written on the command line as
+// comma-separated settings, e.g. "nodes=20000,nnue,hash=32":
+//   nodes=<n> depth=<n> movetime=<ms>   search limits for every move
+//   hash=<MB>                           transposition table size
+//   nnue                                evaluate with the network (see evalfile)
+//   evalfile=<path>                     network to load; one for the whole match
+//   name=<text>                         name in the PGN, the settings otherwise
+struct MatchEngine {
+    std::string name;
+    SearchLimits limits;
+    size_t hashMegabytes = 16;
+    bool useNetwork = false;
+    std::string networkFile;
+
+    // False with a description in `error` for an unknown setting
+    bool parse(const std::string& spec, std::string& error);
+};
+
+// Win/draw/loss counts from the first engine's point of view
+struct MatchScore {
+    uint64_t wins = 0;
+    uint64_t draws = 0;
+    uint64_t losses = 0;
+
+    uint64_t games() const { return wins + draws + losses; }
+    double points() const { return wins + 0.5 * draws; }
+
+    // Elo difference implied by the score, and the half-width of its 95%
+    // confidence interval
+    double elo() const;
+    double eloMargin() const;
+
+    // Log-likelihood ratio of "A is elo1 stronger" against "A is elo0
+    // stronger", with the per-game score treated as normally distributed
+    double llr(double elo0, double elo1) const;
+};
+
+// Bounds of the sequential probability ratio test for false positive rate
+// alpha and false negative rate beta
+double sprtLowerBound(double alpha, double beta);
+double sprtUpperBound(double alpha, double beta);
+
+// Command line entry:
+//   match <openings.epd> <games> <engine A> <engine B> [threads n] [sprt elo0 elo1] [maxplies n]
+// Plays the games concurrently, each opening twice with colors swapped.
+// PGN goes to stdout as each game ends, progress to stderr.
+int runMatch(int argc, char* argv[]);
+
+#endif // MATCH_H
@@ -0,0 +1,63 @@
+#ifndef MOVE_H
+#define MOVE_H
+
+#include "Bitboard.h"
+#include <cstdint>
+#include <string>
+
+// A move packed into 16 bits:
+//   bits 0-5   from square
+//   bits 6-11  to square
+//   bits 12-13 promotion piece (knight, bishop, rook, queen)
+//   bits 14-15 move kind (normal, promotion, en passant, castling)
+typedef uint16_t Move;
+
+enum MoveKind {
+    NORMAL_MOVE = 0,
+    PROMOTION = 1 << 14,
+    EN_PASSANT = 2 << 14,
+    CASTLING = 3 << 14
+};
+
+const Move NO_MOVE = 0;
+
+inline Move encodeMove(int from, int to, MoveKind kind = NORMAL_MOVE, PieceType promotion = KNIGHT) {
+    return static_cast<Move>(from | (to << 6) | ((promotion - KNIGHT) << 12) | kind);
+}
+
+inline int moveFrom(Move m) { return m & 0x3F; }
+inline int moveTo(Move m) { return (m >> 6) & 0x3F; }
+inline MoveKind moveKind(Move m) { return static_cast<MoveKind>(m & (3 << 14)); }
+inline PieceType promotionType(Move m) { return static_cast<PieceType>(KNIGHT + ((m >> 12) & 3)); }
+
+// Coordinate notation as used by UCI, e.g. "e2e4" or "e7e8q"
+inline std::string moveToString(Move m) {
+    std::string result;
+    result += static_cast<char>('a' + colOf(moveFrom(m)));
+    result += static_cast<char>('1' + rowOf(moveFrom(m)));
+    result += static_cast<char>('a' + colOf(moveTo(m)));
+    result += static_cast<char>('1' + rowOf(moveTo(m)));
+    if (moveKind(m) == PROMOTION) {
+        result += "nbrq"[promotionType(m) - KNIGHT];
+    }
+    return result;
+}
+
+// Fixed-capacity move list meant to live on the stack. 256 is above the
+// largest number of legal moves in any reachable position (218).
+struct MoveList {
+    static const int CAPACITY = 256;
+
+    Move moves[CAPACITY];
+    int count = 0;
+
+    void add(Move m) { moves[count++] = m; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    Move operator[](int i) const { return moves[i]; }
+
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + count; }
+};
+
+#endif // MOVE_H
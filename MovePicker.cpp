@@ -0,0 +1,203 @@
+#include "MovePicker.h"
+#include "Evaluate.h"
+#include <algorithm>
+#include <cstdlib>
+
+void HistoryTable::clear() {
+    for (auto& side : scores) {
+        for (auto& from : side) {
+            for (int& score : from) {
+                score = 0;
+            }
+        }
+    }
+}
+
+void HistoryTable::update(Color side, Move move, int bonus) {
+    int& score = scores[side][moveFrom(move)][moveTo(move)];
+    bonus = std::max(-MAX, std::min(MAX, bonus));
+    score += bonus - score * std::abs(bonus) / MAX;
+}
+
+// A king is worth more than anything it could win, so it only recaptures last
+static int exchangeValue(PieceType type) {
+    return type == KING ? 20000 : PIECE_VALUES[type];
+}
+
+int staticExchange(const Board& board, Move move) {
+    if (moveKind(move) == CASTLING) {
+        return 0;
+    }
+
+    int from = moveFrom(move);
+    int to = moveTo(move);
+    Color side = (board.occupancy(WHITE) & squareBB(from)) ? WHITE : BLACK;
+    Bitboard occupancy = board.occupancy() ^ squareBB(from);
+
+    int gain[32];
+    PieceType onSquare = board.pieceTypeAt(from);
+    if (moveKind(move) == EN_PASSANT) {
+        gain[0] = PIECE_VALUES[PAWN];
+        occupancy ^= squareBB(makeSquare(rowOf(from), colOf(to)));
+    } else {
+        PieceType captured = board.pieceTypeAt(to);
+        gain[0] = (captured == NO_PIECE_TYPE) ? 0 : PIECE_VALUES[captured];
+    }
+    if (moveKind(move) == PROMOTION) {
+        onSquare = promotionType(move);
+        gain[0] += PIECE_VALUES[onSquare] - PIECE_VALUES[PAWN];
+    }
+
+    // gain[d] is what the side making capture d wins if the sequence ends
+    // there; it is stored before knowing whether that side has a capturer
+    // and dropped by the backward pass if it has none
+    int d = 0;
+    Bitboard capturer;
+    do {
+        d++;
+        gain[d] = exchangeValue(onSquare) - gain[d - 1];
+        if (std::max(-gain[d - 1], gain[d]) < 0) break;
+
+        side = !side;
+        Bitboard attackers = board.attackersTo(to, occupancy) & occupancy & board.occupancy(side);
+        capturer = 0;
+        for (int t = PAWN; t <= KING; t++) {
+            Bitboard ofType = attackers & board.piecesOf(side, static_cast<PieceType>(t));
+            if (ofType) {
+                capturer = squareBB(lsb(ofType));
+                occupancy ^= capturer;
+                onSquare = static_cast<PieceType>(t);
+                break;
+            }
+        }
+    } while (capturer && d < 31);
+
+    while (--d) {
+        gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+    }
+    return gain[0];
+}
+
+MovePicker::MovePicker(const Board& position, Move hashMove, const Move killerMoves[2], const HistoryTable& table)
+    : board(position), history(table), ttMove(hashMove), stage(STAGE_TT),
+      skipQuiets(false), skipBadCaptures(false), current(0), killerIndex(0), badIndex(0) {
+    killers[0] = killerMoves[0];
+    killers[1] = killerMoves[1];
+    if (!board.isLegalMove(ttMove)) {
+        ttMove = NO_MOVE;
+    }
+}
+
+MovePicker::MovePicker(const Board& position, const HistoryTable& table, bool inCheck)
+    : board(position), history(table), ttMove(NO_MOVE), stage(STAGE_GENERATE_CAPTURES),
+      skipQuiets(!inCheck), skipBadCaptures(!inCheck), current(0), killerIndex(0), badIndex(0) {
+    killers[0] = killers[1] = NO_MOVE;
+}
+
+// Most valuable victim first, least valuable attacker breaking ties;
+// promotions count the piece gained
+void MovePicker::scoreCaptures() {
+    for (int i = 0; i < moves.size(); i++) {
+        Move move = moves[i];
+        PieceType victim = (moveKind(move) == EN_PASSANT) ? PAWN : board.pieceTypeAt(moveTo(move));
+        int score = (victim == NO_PIECE_TYPE) ? 0 : PIECE_VALUES[victim] * 10;
+        if (moveKind(move) == PROMOTION) {
+            score += PIECE_VALUES[promotionType(move)] * 10;
+        }
+        scores[i] = score - PIECE_VALUES[board.pieceTypeAt(moveFrom(move))] / 10;
+    }
+}
+
+void MovePicker::scoreQuiets() {
+    Color us = board.isWhiteTurn ? WHITE : BLACK;
+    for (int i = 0; i < moves.size(); i++) {
+        scores[i] = history.get(us, moves[i]);
+    }
+}
+
+// Selection step: swap the best remaining move to the front. Cheaper than a
+// full sort when a cutoff comes after a few moves.
+Move MovePicker::pickBest() {
+    int best = current;
+    for (int i = current + 1; i < moves.size(); i++) {
+        if (scores[i] > scores[best]) best = i;
+    }
+    std::swap(moves.moves[current], moves.moves[best]);
+    std::swap(scores[current], scores[best]);
+    return moves.moves[current++];
+}
+
+// Moves already handed out by the hash move and killer stages
+bool MovePicker::isSpecial(Move move) const {
+    return move == ttMove || move == killers[0] || move == killers[1];
+}
+
+Move MovePicker::next() {
+    Color us = board.isWhiteTurn ? WHITE : BLACK;
+    while (true) {
+        switch (stage) {
+            case STAGE_TT:
+                stage++;
+                if (ttMove != NO_MOVE) return ttMove;
+                break;
+
+            case STAGE_GENERATE_CAPTURES:
+                moves.count = 0;
+                board.generateLegalMoves(us, moves, GEN_CAPTURES);
+                scoreCaptures();
+                current = 0;
+                stage++;
+                break;
+
+            case STAGE_GOOD_CAPTURES:
+                while (current < moves.size()) {
+                    Move move = pickBest();
+                    if (move == ttMove) continue;
+                    if (staticExchange(board, move) < 0) {
+                        badCaptures.add(move);
+                        continue;
+                    }
+                    return move;
+                }
+                stage = skipQuiets ? STAGE_BAD_CAPTURES : STAGE_KILLERS;
+                break;
+
+            case STAGE_KILLERS:
+                while (killerIndex < 2) {
+                    Move killer = killers[killerIndex++];
+                    if (killer != NO_MOVE && killer != ttMove && moveKind(killer) != PROMOTION &&
+                        !board.isCapture(killer) && board.isLegalMove(killer)) {
+                        return killer;
+                    }
+                }
+                stage++;
+                break;
+
+            case STAGE_GENERATE_QUIETS:
+                moves.count = 0;
+                board.generateLegalMoves(us, moves, GEN_QUIETS);
+                scoreQuiets();
+                current = 0;
+                stage++;
+                break;
+
+            case STAGE_QUIETS:
+                while (current < moves.size()) {
+                    Move move = pickBest();
+                    if (!isSpecial(move)) return move;
+                }
+                stage++;
+                break;
+
+            case STAGE_BAD_CAPTURES:
+                if (!skipBadCaptures && badIndex < badCaptures.size()) {
+                    return badCaptures[badIndex++];
+                }
+                stage = STAGE_DONE;
+                break;
+
+            default:
+                return NO_MOVE;
+        }
+    }
+}
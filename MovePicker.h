@@ -0,0 +1,80 @@
+#ifndef MOVEPICKER_H
+#define MOVEPICKER_H
+
+#include "Board.h"
+#include "Move.h"
+
+// Butterfly history: how often a quiet move from one square to another has
+// caused a cutoff, for each side
+class HistoryTable {
+public:
+    HistoryTable() { clear(); }
+
+    void clear();
+    int get(Color side, Move move) const { return scores[side][moveFrom(move)][moveTo(move)]; }
+
+    // Moves the score toward +/-MAX by `bonus`, so old results fade out
+    void update(Color side, Move move, int bonus);
+
+    static constexpr int MAX = 16384;
+
+private:
+    int scores[2][64][64];
+};
+
+// Static exchange evaluation: the material balance, in centipawns, of the
+// capture sequence on the move's destination square with each side always
+// recapturing with its least valuable piece and free to stop
+int staticExchange(const Board& board, Move move);
+
+// Hands out the legal moves of a position best-first, one at a time, doing
+// only as much generation and scoring as the caller asks for. Stages:
+// hash move, captures that do not lose material (by most valuable victim /
+// least valuable attacker), the two killer moves, quiet moves by history,
+// then captures that lose material.
+class MovePicker {
+public:
+    // Main search
+    MovePicker(const Board& board, Move ttMove, const Move killers[2], const HistoryTable& history);
+
+    // Quiescence: only captures that do not lose material, unless in check
+    // when every evasion is needed
+    MovePicker(const Board& board, const HistoryTable& history, bool inCheck);
+
+    // The next move, or NO_MOVE when none are left
+    Move next();
+
+private:
+    enum Stage {
+        STAGE_TT,
+        STAGE_GENERATE_CAPTURES,
+        STAGE_GOOD_CAPTURES,
+        STAGE_KILLERS,
+        STAGE_GENERATE_QUIETS,
+        STAGE_QUIETS,
+        STAGE_BAD_CAPTURES,
+        STAGE_DONE
+    };
+
+    const Board& board;
+    const HistoryTable& history;
+    Move ttMove;
+    Move killers[2];
+    int stage;
+    bool skipQuiets;
+    bool skipBadCaptures;
+
+    MoveList moves;
+    int scores[MoveList::CAPACITY];
+    int current;
+    int killerIndex;
+    MoveList badCaptures;
+    int badIndex;
+
+    void scoreCaptures();
+    void scoreQuiets();
+    Move pickBest();
+    bool isSpecial(Move move) const;
+};
+
+#endif // MOVEPICKER_H
@@ -0,0 +1,279 @@
+#include "Nnue.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NNUE_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// The SIMD kernels are compiled for their instruction set regardless of the
+// build flags and only called after checking the CPU supports it
+#if defined(NNUE_X86) && defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#else
+#define TARGET_AVX2
+#define TARGET_SSE41
+#endif
+
+Network nnueNetwork;
+
+// Input index of a piece seen from one side; Black's view is mirrored so both
+// sides share the weights
+static int featureIndex(Color perspective, int kingSq, Color color, PieceType type, int sq) {
+    if (perspective == BLACK) {
+        kingSq ^= 56;
+        sq ^= 56;
+    }
+    int kind = type * 2 + (color == perspective ? 0 : 1);
+    return (kingSq * NNUE_PIECE_KINDS + kind) * 64 + sq;
+}
+
+// out[o] = bias[o] + dot(input, weights row o), for unsigned 8-bit inputs
+// and signed 8-bit weights. Input sizes are multiples of 32.
+typedef void (*AffineKernel)(const uint8_t* input, int inputs, const int8_t* weights,
+                             const int32_t* biases, int32_t* output, int outputs);
+
+static void affineScalar(const uint8_t* input, int inputs, const int8_t* weights,
+                         const int32_t* biases, int32_t* output, int outputs) {
+    for (int o = 0; o < outputs; o++) {
+        const int8_t* row = weights + o * inputs;
+        int32_t sum = biases[o];
+        for (int i = 0; i < inputs; i++) {
+            sum += input[i] * row[i];
+        }
+        output[o] = sum;
+    }
+}
+
+#ifdef NNUE_X86
+TARGET_SSE41 static void affineSse41(const uint8_t* input, int inputs, const int8_t* weights,
+                                     const int32_t* biases, int32_t* output, int outputs) {
+    const __m128i ones = _mm_set1_epi16(1);
+    for (int o = 0; o < outputs; o++) {
+        const int8_t* row = weights + o * inputs;
+        __m128i sum = _mm_setzero_si128();
+        for (int i = 0; i < inputs; i += 16) {
+            __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+            __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(in, w), ones));
+        }
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+        output[o] = biases[o] + _mm_cvtsi128_si32(sum);
+    }
+}
+
+TARGET_AVX2 static void affineAvx2(const uint8_t* input, int inputs, const int8_t* weights,
+                                   const int32_t* biases, int32_t* output, int outputs) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (int o = 0; o < outputs; o++) {
+        const int8_t* row = weights + o * inputs;
+        __m256i sum = _mm256_setzero_si256();
+        for (int i = 0; i < inputs; i += 32) {
+            __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+            __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(in, w), ones));
+        }
+        __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+        output[o] = biases[o] + _mm_cvtsi128_si32(half);
+    }
+}
+#endif
+
+enum SimdLevel { SIMD_SCALAR, SIMD_SSE41, SIMD_AVX2 };
+
+static SimdLevel detectSimd() {
+#if defined(NNUE_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return SIMD_SSE41;
+#elif defined(NNUE_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool sse41 = (info[2] >> 19) & 1;
+    bool osSavesYmm = ((info[2] >> 27) & 1) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    if (osSavesYmm && ((info[1] >> 5) & 1)) return SIMD_AVX2;
+    if (sse41) return SIMD_SSE41;
+#endif
+    return SIMD_SCALAR;
+}
+
+static SimdLevel simdLevel() {
+    static const SimdLevel level = detectSimd();
+    return level;
+}
+
+static AffineKernel affineKernel() {
+#ifdef NNUE_X86
+    switch (simdLevel()) {
+        case SIMD_AVX2: return affineAvx2;
+        case SIMD_SSE41: return affineSse41;
+        default: break;
+    }
+#endif
+    return affineScalar;
+}
+
+const char* Network::simdName() {
+    switch (simdLevel()) {
+        case SIMD_AVX2: return "AVX2";
+        case SIMD_SSE41: return "SSE4.1";
+        default: return "scalar";
+    }
+}
+
+bool Network::load(const std::string& path) {
+    file.close();
+    if (!file.open(path)) {
+        return false;
+    }
+
+    const char* base = file.data();
+    uint32_t dims[4];
+    if (file.size() < 64 || std::memcmp(base, "CHSNNUE1", 8) != 0) {
+        file.close();
+        return false;
+    }
+    std::memcpy(dims, base + 8, sizeof(dims));
+    if (dims[0] != NNUE_INPUTS || dims[1] != NNUE_HALF || dims[2] != NNUE_L1 || dims[3] != NNUE_L2) {
+        file.close();
+        return false;
+    }
+
+    // Sections follow the header, each padded to 64 bytes
+    size_t offset = 64;
+    auto section = [&](size_t bytes) {
+        const char* p = base + offset;
+        offset += (bytes + 63) & ~size_t(63);
+        return p;
+    };
+    featureBiases = reinterpret_cast<const int16_t*>(section(NNUE_HALF * sizeof(int16_t)));
+    featureWeights = reinterpret_cast<const int16_t*>(section(size_t(NNUE_INPUTS) * NNUE_HALF * sizeof(int16_t)));
+    l1Biases = reinterpret_cast<const int32_t*>(section(NNUE_L1 * sizeof(int32_t)));
+    l1Weights = reinterpret_cast<const int8_t*>(section(NNUE_L1 * 2 * NNUE_HALF));
+    l2Biases = reinterpret_cast<const int32_t*>(section(NNUE_L2 * sizeof(int32_t)));
+    l2Weights = reinterpret_cast<const int8_t*>(section(NNUE_L2 * NNUE_L1));
+    outputBias = reinterpret_cast<const int32_t*>(section(sizeof(int32_t)));
+    outputWeights = reinterpret_cast<const int8_t*>(section(NNUE_L2));
+    if (offset > file.size()) {
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+void Network::refreshSide(const Board& board, Color perspective, int16_t* values) const {
+    std::memcpy(values, featureBiases, NNUE_HALF * sizeof(int16_t));
+    int kingSq = board.getKingSquare(perspective);
+    for (int c = 0; c < 2; c++) {
+        for (int t = PAWN; t < KING; t++) {
+            Bitboard b = board.piecesOf(static_cast<Color>(c), static_cast<PieceType>(t));
+            while (b) {
+                int index = featureIndex(perspective, kingSq, static_cast<Color>(c), static_cast<PieceType>(t), popLsb(b));
+                const int16_t* column = featureWeights + size_t(index) * NNUE_HALF;
+                for (int i = 0; i < NNUE_HALF; i++) {
+                    values[i] += column[i];
+                }
+            }
+        }
+    }
+}
+
+void Network::refresh(const Board& board, Accumulator& acc) const {
+    refreshSide(board, WHITE, acc.values[WHITE]);
+    refreshSide(board, BLACK, acc.values[BLACK]);
+}
+
+void Network::update(const Board& board, const UndoInfo& undo, const Accumulator& parent, Accumulator& acc) const {
+    Color us = board.isWhiteTurn ? BLACK : WHITE;  // The side that made the move
+    Color them = !us;
+    int from = moveFrom(undo.move);
+    int to = moveTo(undo.move);
+    MoveKind kind = moveKind(undo.move);
+
+    for (int p = 0; p < 2; p++) {
+        Color perspective = static_cast<Color>(p);
+
+        // Every feature depends on the king square, so a king move
+        // invalidates that side's whole accumulator
+        if (undo.moved == KING && perspective == us) {
+            refreshSide(board, perspective, acc.values[p]);
+            continue;
+        }
+
+        int kingSq = board.getKingSquare(perspective);
+        int added[2];
+        int removed[2];
+        int addedCount = 0;
+        int removedCount = 0;
+
+        // Kings are not features, so a king move only touches the castling rook
+        if (undo.moved != KING) {
+            removed[removedCount++] = featureIndex(perspective, kingSq, us, undo.moved, from);
+            PieceType placed = (kind == PROMOTION) ? promotionType(undo.move) : undo.moved;
+            added[addedCount++] = featureIndex(perspective, kingSq, us, placed, to);
+        }
+        if (undo.captured != NO_PIECE_TYPE) {
+            int capturedSq = (kind == EN_PASSANT) ? makeSquare(rowOf(from), colOf(to)) : to;
+            removed[removedCount++] = featureIndex(perspective, kingSq, them, undo.captured, capturedSq);
+        }
+        if (kind == CASTLING) {
+            int row = rowOf(from);
+            removed[removedCount++] = featureIndex(perspective, kingSq, us, ROOK, makeSquare(row, to > from ? 7 : 0));
+            added[addedCount++] = featureIndex(perspective, kingSq, us, ROOK, makeSquare(row, to > from ? 5 : 3));
+        }
+
+        const int16_t* source = parent.values[p];
+        int16_t* values = acc.values[p];
+        std::memcpy(values, source, NNUE_HALF * sizeof(int16_t));
+        for (int k = 0; k < addedCount; k++) {
+            const int16_t* column = featureWeights + size_t(added[k]) * NNUE_HALF;
+            for (int i = 0; i < NNUE_HALF; i++) values[i] += column[i];
+        }
+        for (int k = 0; k < removedCount; k++) {
+            const int16_t* column = featureWeights + size_t(removed[k]) * NNUE_HALF;
+            for (int i = 0; i < NNUE_HALF; i++) values[i] -= column[i];
+        }
+    }
+}
+
+// Hidden layer outputs are scaled by 64 before clipping, the final output by 16
+static void clipLayer(const int32_t* input, uint8_t* output, int count) {
+    for (int i = 0; i < count; i++) {
+        output[i] = static_cast<uint8_t>(std::min(127, std::max(0, input[i] >> 6)));
+    }
+}
+
+int Network::evaluate(const Accumulator& acc, Color sideToMove) const {
+    static const AffineKernel affine = affineKernel();
+
+    alignas(64) uint8_t input[2 * NNUE_HALF];
+    const int16_t* halves[2] = { acc.values[sideToMove], acc.values[!sideToMove] };
+    for (int h = 0; h < 2; h++) {
+        for (int i = 0; i < NNUE_HALF; i++) {
+            input[h * NNUE_HALF + i] = static_cast<uint8_t>(std::min<int>(127, std::max<int>(0, halves[h][i])));
+        }
+    }
+
+    alignas(64) int32_t l1Out[NNUE_L1];
+    alignas(64) uint8_t l1Clipped[NNUE_L1];
+    affine(input, 2 * NNUE_HALF, l1Weights, l1Biases, l1Out, NNUE_L1);
+    clipLayer(l1Out, l1Clipped, NNUE_L1);
+
+    alignas(64) int32_t l2Out[NNUE_L2];
+    alignas(64) uint8_t l2Clipped[NNUE_L2];
+    affine(l1Clipped, NNUE_L1, l2Weights, l2Biases, l2Out, NNUE_L2);
+    clipLayer(l2Out, l2Clipped, NNUE_L2);
+
+    int32_t output;
+    affine(l2Clipped, NNUE_L2, outputWeights, outputBias, &output, 1);
+    return output / 16;
+}
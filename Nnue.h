@@ -0,0 +1,78 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include "Board.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+
+// Efficiently updatable neural network evaluation.
+//
+// Input features are HalfKP-like: for each side's point of view, one input
+// per (own king square, non-king piece, piece square), with Black's view
+// mirrored vertically. The first layer turns them into a 256-wide
+// accumulator per side. Since a move changes only a few features, the
+// accumulator is updated by adding and subtracting weight columns instead of
+// being recomputed, except for the side whose king moved.
+//
+// The rest of the network is small and quantized: the two accumulators (side
+// to move first) are clipped to 0..127 and fed through 512 -> 32 -> 32 -> 1
+// int8 layers with int32 biases and clipped ReLU between them.
+//
+// Weight file layout (little-endian, every section starting on a 64-byte
+// boundary so it can be used in place from a memory mapping):
+//   header      char magic[8] "CHSNNUE1", uint32 inputs, half, l1, l2
+//   int16       feature biases[256]
+//   int16       feature weights[INPUTS][256]
+//   int32       l1 biases[32], then int8 l1 weights[32][512]
+//   int32       l2 biases[32], then int8 l2 weights[32][32]
+//   int32       output bias, then int8 output weights[32]
+const int NNUE_KING_SQUARES = 64;
+const int NNUE_PIECE_KINDS = 10;    // Pawn to queen, for each color
+const int NNUE_INPUTS = NNUE_KING_SQUARES * NNUE_PIECE_KINDS * 64;
+const int NNUE_HALF = 256;
+const int NNUE_L1 = 32;
+const int NNUE_L2 = 32;
+
+// First-layer output for both points of view, indexed by Color
+struct Accumulator {
+    alignas(64) int16_t values[2][NNUE_HALF];
+};
+
+class Network {
+public:
+    // Maps the weight file; on failure no network is loaded
+    bool load(const std::string& path);
+    bool isLoaded() const { return file.isOpen(); }
+
+    // Compute an accumulator from scratch
+    void refresh(const Board& board, Accumulator& acc) const;
+
+    // Derive the accumulator of `board`, the position after undo.move, from
+    // the accumulator of the position before it
+    void update(const Board& board, const UndoInfo& undo, const Accumulator& parent, Accumulator& acc) const;
+
+    // Centipawns for the side to move
+    int evaluate(const Accumulator& acc, Color sideToMove) const;
+
+    // Name of the instruction set the output layers run on
+    static const char* simdName();
+
+private:
+    MappedFile file;
+    const int16_t* featureBiases = nullptr;
+    const int16_t* featureWeights = nullptr;
+    const int32_t* l1Biases = nullptr;
+    const int8_t* l1Weights = nullptr;
+    const int32_t* l2Biases = nullptr;
+    const int8_t* l2Weights = nullptr;
+    const int32_t* outputBias = nullptr;
+    const int8_t* outputWeights = nullptr;
+
+    void refreshSide(const Board& board, Color perspective, int16_t* values) const;
+};
+
+// The network shared by every search thread
+extern Network nnueNetwork;
+
+#endif // NNUE_H
@@ -0,0 +1,111 @@
+#include "Perft.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+uint64_t perft(Board& board, int depth) {
+    MoveList moves;
+    board.generateLegalMoves(board.isWhiteTurn ? WHITE : BLACK, moves);
+    if (depth <= 1) {
+        return depth == 1 ? moves.size() : 1;
+    }
+
+    uint64_t nodes = 0;
+    for (Move move : moves) {
+        UndoInfo undo;
+        board.doMove(move, undo);
+        nodes += perft(board, depth - 1);
+        board.undoMove(undo);
+    }
+    return nodes;
+}
+
+uint64_t perftDivide(const Board& board, int depth, int threads) {
+    MoveList moves;
+    board.generateLegalMoves(board.isWhiteTurn ? WHITE : BLACK, moves);
+
+    std::vector<uint64_t> counts(moves.size(), 0);
+    std::atomic<int> next(0);
+
+    auto worker = [&]() {
+        Board local = board;
+        for (int i = next++; i < moves.size(); i = next++) {
+            UndoInfo undo;
+            local.doMove(moves[i], undo);
+            counts[i] = perft(local, depth - 1);
+            local.undoMove(undo);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; i++) {
+        pool.emplace_back(worker);
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+
+    uint64_t total = 0;
+    for (int i = 0; i < moves.size(); i++) {
+        std::cout << moveToString(moves[i]) << ": " << counts[i] << "\n";
+        total += counts[i];
+    }
+    return total;
+}
+
+int runPerft(int argc, char* argv[]) {
+    if (argc < 1) {
+        std::cerr << "Usage: chess perft <depth> [fen <fen>] [moves] [move ...]\n";
+        return 1;
+    }
+
+    int depth = std::atoi(argv[0]);
+    if (depth < 1) {
+        std::cerr << "Depth must be at least 1\n";
+        return 1;
+    }
+
+    // An optional FEN (quoted or as separate fields) replaces the start
+    // position; any moves after it are played first
+    Board board;
+    int i = 1;
+    if (i < argc && std::string(argv[i]) == "fen") {
+        std::string fen;
+        for (i++; i < argc && std::string(argv[i]) != "moves"; i++) {
+            if (!fen.empty()) fen += ' ';
+            fen += argv[i];
+        }
+        if (!board.fromFEN(fen)) {
+            std::cerr << "Invalid FEN: " << fen << "\n";
+            return 1;
+        }
+    }
+    if (i < argc && std::string(argv[i]) == "moves") {
+        i++;
+    }
+    for (; i < argc; i++) {
+        Move move = board.moveFromString(argv[i]);
+        if (move == NO_MOVE) {
+            std::cerr << "Illegal move: " << argv[i] << "\n";
+            return 1;
+        }
+        UndoInfo undo;
+        board.doMove(move, undo);
+    }
+
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (threads < 1) threads = 1;
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t nodes = perftDivide(board, depth, threads);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "\nNodes searched: " << nodes << "\n";
+    std::cout << "Time: " << static_cast<long long>(seconds * 1000) << " ms, "
+              << threads << " threads\n";
+    std::cout << "Nodes/second: " << static_cast<uint64_t>(nodes / (seconds > 0 ? seconds : 1e-9)) << "\n";
+    return 0;
+}
@@ -0,0 +1,17 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include "Board.h"
+#include <cstdint>
+
+// Count the leaf nodes of the legal move tree to the given depth
+uint64_t perft(Board& board, int depth);
+
+// Perft with a per-root-move breakdown ("divide"). Root moves are shared out
+// to `threads` workers, each searching its own copy of the board.
+uint64_t perftDivide(const Board& board, int depth, int threads);
+
+// Command line entry: perft <depth> [fen <fen>] [moves] [move ...]
+int runPerft(int argc, char* argv[]);
+
+#endif // PERFT_H
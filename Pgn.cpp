@@ -0,0 +1,435 @@
+#include "Pgn.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+Move parseSan(const Board& board, std::string_view san) {
+    // Check, mate and annotation suffixes carry no move information
+    while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?')) {
+        san.remove_suffix(1);
+    }
+    if (san.empty()) {
+        return NO_MOVE;
+    }
+
+    MoveList moves;
+    board.generateLegalMoves(board.isWhiteTurn ? WHITE : BLACK, moves);
+
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+        int col = (san.size() == 3) ? 6 : 2;
+        for (Move move : moves) {
+            if (moveKind(move) == CASTLING && colOf(moveTo(move)) == col) {
+                return move;
+            }
+        }
+        return NO_MOVE;
+    }
+
+    PieceType piece = PAWN;
+    switch (san.front()) {
+        case 'N': piece = KNIGHT; break;
+        case 'B': piece = BISHOP; break;
+        case 'R': piece = ROOK; break;
+        case 'Q': piece = QUEEN; break;
+        case 'K': piece = KING; break;
+        default: break;
+    }
+    if (piece != PAWN) {
+        san.remove_prefix(1);
+    }
+
+    // Promotion piece, written "e8=Q" or "e8Q"
+    PieceType promotion = NO_PIECE_TYPE;
+    if (piece == PAWN && san.size() >= 3) {
+        switch (san.back()) {
+            case 'N': promotion = KNIGHT; break;
+            case 'B': promotion = BISHOP; break;
+            case 'R': promotion = ROOK; break;
+            case 'Q': promotion = QUEEN; break;
+            default: break;
+        }
+        if (promotion != NO_PIECE_TYPE) {
+            san.remove_suffix(1);
+            if (san.back() == '=') san.remove_suffix(1);
+        }
+    }
+
+    // Destination is the last square; anything before it other than capture
+    // and dash marks disambiguates the origin
+    if (san.size() < 2) {
+        return NO_MOVE;
+    }
+    char toFile = san[san.size() - 2];
+    char toRank = san[san.size() - 1];
+    if (toFile < 'a' || toFile > 'h' || toRank < '1' || toRank > '8') {
+        return NO_MOVE;
+    }
+    int to = makeSquare(toRank - '1', toFile - 'a');
+
+    int fromFile = -1;
+    int fromRank = -1;
+    for (size_t i = 0; i + 2 < san.size(); i++) {
+        char c = san[i];
+        if (c >= 'a' && c <= 'h') fromFile = c - 'a';
+        else if (c >= '1' && c <= '8') fromRank = c - '1';
+        else if (c != 'x' && c != '-' && c != ':') return NO_MOVE;
+    }
+
+    Move found = NO_MOVE;
+    for (Move move : moves) {
+        int from = moveFrom(move);
+        if (moveTo(move) != to || board.pieceTypeAt(from) != piece) continue;
+        if (fromFile != -1 && colOf(from) != fromFile) continue;
+        if (fromRank != -1 && rowOf(from) != fromRank) continue;
+        if (moveKind(move) == PROMOTION) {
+            PieceType wanted = (promotion == NO_PIECE_TYPE) ? QUEEN : promotion;
+            if (promotionType(move) != wanted) continue;
+        } else if (promotion != NO_PIECE_TYPE) {
+            continue;
+        }
+        if (found != NO_MOVE) {
+            return NO_MOVE;  // Ambiguous
+        }
+        found = move;
+    }
+    return found;
+}
+
+std::string moveToSan(const Board& board, Move move) {
+    static const char PIECE_LETTERS[] = "PNBRQK";
+    int from = moveFrom(move);
+    int to = moveTo(move);
+    std::string san;
+
+    if (moveKind(move) == CASTLING) {
+        san = (colOf(to) == 6) ? "O-O" : "O-O-O";
+    } else {
+        PieceType piece = board.pieceTypeAt(from);
+        if (piece == PAWN) {
+            if (board.isCapture(move)) {
+                san += static_cast<char>('a' + colOf(from));
+            }
+        } else {
+            san += PIECE_LETTERS[piece];
+
+            // Name the origin file, else its rank, else both, when another
+            // piece of the same kind can reach the square
+            MoveList moves;
+            board.generateLegalMoves(board.isWhiteTurn ? WHITE : BLACK, moves);
+            bool ambiguous = false, sameFile = false, sameRank = false;
+            for (Move other : moves) {
+                int otherFrom = moveFrom(other);
+                if (moveTo(other) != to || otherFrom == from || board.pieceTypeAt(otherFrom) != piece) continue;
+                ambiguous = true;
+                if (colOf(otherFrom) == colOf(from)) sameFile = true;
+                if (rowOf(otherFrom) == rowOf(from)) sameRank = true;
+            }
+            if (ambiguous && (!sameFile || sameRank)) san += static_cast<char>('a' + colOf(from));
+            if (ambiguous && sameFile) san += static_cast<char>('1' + rowOf(from));
+        }
+        if (board.isCapture(move)) {
+            san += 'x';
+        }
+        san += static_cast<char>('a' + colOf(to));
+        san += static_cast<char>('1' + rowOf(to));
+        if (moveKind(move) == PROMOTION) {
+            san += '=';
+            san += PIECE_LETTERS[promotionType(move)];
+        }
+    }
+
+    Board after = board;
+    UndoInfo undo;
+    after.doMove(move, undo);
+    GameStatus status = after.status();
+    if (status == CHECKMATE) san += '#';
+    else if (after.isInCheck(after.isWhiteTurn)) san += '+';
+    return san;
+}
+
+enum TokenKind { TOKEN_END, TOKEN_MOVE, TOKEN_RESULT };
+
+static bool isResult(std::string_view token) {
+    return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Next move or result in movetext, skipping comments, variations, NAGs,
+// move numbers and "e.p." markers. Stops without consuming at a '[' since
+// that starts the next game's tags.
+static TokenKind nextToken(std::string_view text, size_t& pos, std::string_view& token) {
+    size_t n = text.size();
+    while (pos < n) {
+        char c = text[pos];
+        if (isSpace(c)) {
+            pos++;
+        } else if (c == '{') {
+            size_t close = text.find('}', pos);
+            pos = (close == std::string_view::npos) ? n : close + 1;
+        } else if (c == ';' || (c == '%' && (pos == 0 || text[pos - 1] == '\n'))) {
+            size_t eol = text.find('\n', pos);
+            pos = (eol == std::string_view::npos) ? n : eol + 1;
+        } else if (c == '(') {
+            int depth = 0;
+            for (; pos < n; pos++) {
+                if (text[pos] == '{') {
+                    size_t close = text.find('}', pos);
+                    pos = (close == std::string_view::npos) ? n - 1 : close;
+                } else if (text[pos] == '(') {
+                    depth++;
+                } else if (text[pos] == ')' && --depth == 0) {
+                    pos++;
+                    break;
+                }
+            }
+        } else if (c == '$' || c == ')') {
+            pos++;
+            while (pos < n && text[pos] >= '0' && text[pos] <= '9') pos++;
+        } else if (c == '[') {
+            return TOKEN_END;
+        } else {
+            size_t start = pos;
+            while (pos < n && !isSpace(text[pos]) && text[pos] != '{' && text[pos] != '(' &&
+                   text[pos] != ')' && text[pos] != ';' && text[pos] != '[') {
+                pos++;
+            }
+            token = text.substr(start, pos - start);
+            if (isResult(token)) {
+                return TOKEN_RESULT;
+            }
+
+            // Move number prefix such as "12." or "12..." (possibly glued to the move)
+            size_t skip = 0;
+            while (skip < token.size() && token[skip] >= '0' && token[skip] <= '9') skip++;
+            if (skip < token.size() && token[skip] == '.') {
+                while (skip < token.size() && token[skip] == '.') skip++;
+                token.remove_prefix(skip);
+            } else if (skip == token.size()) {
+                continue;  // Bare number
+            }
+            while (!token.empty() && token.front() == '.') token.remove_prefix(1);
+
+            if (token.empty() || token == "e.p." || token == "ep") {
+                continue;
+            }
+            return TOKEN_MOVE;
+        }
+    }
+    return TOKEN_END;
+}
+
+std::string_view PgnGame::tag(std::string_view name) const {
+    size_t pos = 0;
+    while ((pos = tags.find('[', pos)) != std::string_view::npos) {
+        pos++;
+        if (tags.compare(pos, name.size(), name) == 0 && pos + name.size() < tags.size() &&
+            tags[pos + name.size()] == ' ') {
+            size_t open = tags.find('"', pos + name.size());
+            if (open == std::string_view::npos) return std::string_view();
+            size_t close = tags.find('"', open + 1);
+            if (close == std::string_view::npos) return std::string_view();
+            return tags.substr(open + 1, close - open - 1);
+        }
+    }
+    return std::string_view();
+}
+
+bool PgnReader::next(PgnGame& game) {
+    while (pos < text.size() && isSpace(text[pos])) pos++;
+    if (pos >= text.size()) {
+        return false;
+    }
+
+    // Tag pairs, one per line
+    size_t tagStart = pos;
+    while (pos < text.size() && text[pos] == '[') {
+        size_t eol = text.find('\n', pos);
+        pos = (eol == std::string_view::npos) ? text.size() : eol + 1;
+        while (pos < text.size() && isSpace(text[pos])) pos++;
+    }
+    game.tags = text.substr(tagStart, pos - tagStart);
+
+    // Movetext runs to the result marker or the next game's tags
+    size_t moveStart = pos;
+    std::string_view token;
+    TokenKind kind;
+    while ((kind = nextToken(text, pos, token)) == TOKEN_MOVE) {
+    }
+    game.movetext = text.substr(moveStart, pos - moveStart);
+    return kind == TOKEN_RESULT || !game.tags.empty() || !game.movetext.empty();
+}
+
+bool replayGame(const PgnGame& game, Board& board, std::string_view& result, std::string& error,
+                const std::function<void(const Board&, Move)>& onMove) {
+    std::string_view fen = game.tag("FEN");
+    if (fen.empty()) {
+        board = Board();
+    } else if (!board.fromFEN(fen)) {
+        error = "invalid FEN tag";
+        return false;
+    }
+
+    result = std::string_view();
+    size_t pos = 0;
+    int ply = 0;
+    std::string_view token;
+    TokenKind kind;
+    while ((kind = nextToken(game.movetext, pos, token)) == TOKEN_MOVE) {
+        Move move = parseSan(board, token);
+        if (move == NO_MOVE) {
+            error = "illegal or ambiguous move '" + std::string(token) + "' at ply " + std::to_string(ply + 1);
+            return false;
+        }
+        if (onMove) onMove(board, move);
+        UndoInfo undo;
+        board.doMove(move, undo);
+        ply++;
+    }
+    if (kind == TOKEN_RESULT) {
+        result = token;
+    }
+
+    // The recorded result has to agree with how the game actually ended
+    std::string_view tagResult = game.tag("Result");
+    if (!result.empty() && !tagResult.empty() && tagResult != result) {
+        error = "Result tag " + std::string(tagResult) + " does not match " + std::string(result);
+        return false;
+    }
+    GameStatus status = board.status();
+    if (status == CHECKMATE && !result.empty() && result != (board.isWhiteTurn ? "0-1" : "1-0")) {
+        error = "game ends in checkmate but is scored " + std::string(result);
+        return false;
+    }
+    if (status == STALEMATE && !result.empty() && result != "1/2-1/2") {
+        error = "game ends in stalemate but is scored " + std::string(result);
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+struct ShardReport {
+    size_t games = 0;
+    size_t errors = 0;
+    size_t whiteWins = 0;
+    size_t blackWins = 0;
+    size_t draws = 0;
+    size_t unfinished = 0;
+    uint64_t plies = 0;
+    std::vector<std::pair<size_t, std::string>> messages;  // Shard-local game index, text
+};
+
+// Split points for sharding: each one is moved forward to the next game start
+// (a tag line after a blank line)
+std::vector<size_t> findShards(std::string_view text, int shards) {
+    std::vector<size_t> bounds(1, 0);
+    for (int i = 1; i < shards; i++) {
+        size_t pos = std::max(bounds.back(), text.size() * i / shards);
+        size_t found = std::string_view::npos;
+        while ((pos = text.find("\n[", pos)) != std::string_view::npos) {
+            size_t back = pos;
+            while (back > 0 && (text[back - 1] == '\r' || text[back - 1] == ' ')) back--;
+            if (back > 0 && text[back - 1] == '\n') {
+                found = pos + 1;
+                break;
+            }
+            pos++;
+        }
+        bounds.push_back(found == std::string_view::npos ? text.size() : found);
+    }
+    bounds.push_back(text.size());
+    return bounds;
+}
+
+void validateShard(std::string_view text, ShardReport& report) {
+    PgnReader reader(text);
+    PgnGame game;
+    Board board;
+    std::string error;
+    std::string_view result;
+    uint64_t plies = 0;
+    auto countPly = [&plies](const Board&, Move) { plies++; };
+
+    while (reader.next(game)) {
+        if (!replayGame(game, board, result, error, countPly)) {
+            report.errors++;
+            std::string label = std::string(game.tag("White")) + " - " + std::string(game.tag("Black"));
+            report.messages.emplace_back(report.games, "(" + label + "): " + error);
+        } else if (result == "1-0") {
+            report.whiteWins++;
+        } else if (result == "0-1") {
+            report.blackWins++;
+        } else if (result == "1/2-1/2") {
+            report.draws++;
+        } else {
+            report.unfinished++;
+        }
+        report.games++;
+    }
+    report.plies = plies;
+}
+
+}  // namespace
+
+int runPgn(int argc, char* argv[]) {
+    if (argc < 1) {
+        std::cerr << "Usage: chess pgn <file> [threads]\n";
+        return 1;
+    }
+
+    MappedFile file;
+    if (!file.open(argv[0])) {
+        std::cerr << "Cannot open " << argv[0] << "\n";
+        return 1;
+    }
+
+    int threads = (argc > 1) ? std::atoi(argv[1]) : static_cast<int>(std::thread::hardware_concurrency());
+    if (threads < 1) threads = 1;
+
+    auto start = std::chrono::steady_clock::now();
+    std::string_view text = file.view();
+    std::vector<size_t> bounds = findShards(text, threads);
+    std::vector<ShardReport> reports(threads);
+
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; i++) {
+        std::string_view shard = text.substr(bounds[i], bounds[i + 1] - bounds[i]);
+        pool.emplace_back(validateShard, shard, std::ref(reports[i]));
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Errors in file order, numbered from 1 across shards
+    ShardReport total;
+    for (const ShardReport& r : reports) {
+        for (const auto& message : r.messages) {
+            std::cout << "Game " << (total.games + message.first + 1) << " " << message.second << "\n";
+        }
+        total.games += r.games;
+        total.errors += r.errors;
+        total.whiteWins += r.whiteWins;
+        total.blackWins += r.blackWins;
+        total.draws += r.draws;
+        total.unfinished += r.unfinished;
+        total.plies += r.plies;
+    }
+
+    std::cout << "\nGames: " << total.games << ", valid: " << (total.games - total.errors)
+              << ", errors: " << total.errors << "\n";
+    std::cout << "1-0: " << total.whiteWins << ", 0-1: " << total.blackWins
+              << ", 1/2-1/2: " << total.draws << ", unfinished: " << total.unfinished << "\n";
+    std::cout << "Moves: " << total.plies << ", time: " << static_cast<long long>(seconds * 1000)
+              << " ms, " << threads << " threads\n";
+    std::cout << "Games/minute: " << static_cast<uint64_t>(total.games * 60 / (seconds > 0 ? seconds : 1e-9)) << "\n";
+    return total.errors ? 2 : 0;
+}
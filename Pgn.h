@@ -0,0 +1,48 @@
+#ifndef PGN_H
+#define PGN_H
+
+#include "Board.h"
+#include "Move.h"
+#include <functional>
+#include <string>
+#include <string_view>
+
+// Resolve a move in Standard Algebraic Notation ("Nbd7", "exd6", "O-O-O",
+// "e8=Q+") against the legal moves of the position. Returns NO_MOVE if the
+// text matches no legal move or more than one.
+Move parseSan(const Board& board, std::string_view san);
+
+// Write a legal move of the position in Standard Algebraic Notation, with
+// the least disambiguation needed and a "+" or "#" suffix
+std::string moveToSan(const Board& board, Move move);
+
+// One game inside a PGN text. Both views point into the caller's buffer.
+struct PgnGame {
+    std::string_view tags;          // Tag pair section, e.g. [Event "..."] lines
+    std::string_view movetext;      // Moves, comments and the result marker
+
+    // Value of a tag pair, or an empty view if the game does not have it
+    std::string_view tag(std::string_view name) const;
+};
+
+// Splits PGN text into games without copying it
+class PgnReader {
+public:
+    explicit PgnReader(std::string_view text) : text(text), pos(0) {}
+    bool next(PgnGame& game);
+
+private:
+    std::string_view text;
+    size_t pos;
+};
+
+// Play a game's moves on `board`, starting from its FEN tag if it has one.
+// onMove sees the position before each move. Returns false with a
+// description in `error` when a move cannot be resolved.
+bool replayGame(const PgnGame& game, Board& board, std::string_view& result, std::string& error,
+                const std::function<void(const Board&, Move)>& onMove = nullptr);
+
+// Command line entry: pgn <file> [threads]
+int runPgn(int argc, char* argv[]);
+
+#endif // PGN_H
@@ -1,112 +1,74 @@
 #include "Piece.h"
 #include "Board.h"
+#include <cctype>
 #include <cstdlib>
 
-// Helper function to check if path is clear (for pieces that move in straight lines)
-bool isPathClear(const Position& from, const Position& to, const Board& board) {
-    int rowStep = (to.row - from.row) ? (to.row - from.row) / abs(to.row - from.row) : 0;
-    int colStep = (to.col - from.col) ? (to.col - from.col) / abs(to.col - from.col) : 0;
-    
-    Position current(from.row + rowStep, from.col + colStep);
-    while (current != to) {
-        if (board.getPiece(current) != nullptr) return false;
-        current.row += rowStep;
-        current.col += colStep;
+Piece::Piece(bool isWhite, char sym) : Piece() {
+    PieceType type = NO_PIECE_TYPE;
+    switch (toupper(sym)) {
+        case 'P': type = PAWN; break;
+        case 'N': type = KNIGHT; break;
+        case 'B': type = BISHOP; break;
+        case 'R': type = ROOK; break;
+        case 'Q': type = QUEEN; break;
+        case 'K': type = KING; break;
+        default: break;
     }
-    return true;
+    *this = Piece(isWhite ? WHITE : BLACK, type);
 }
 
-// Pawn movement
-bool Pawn::isValidMove(const Position& from, const Position& to, const Board& board) const {
-    int direction = white ? 1 : -1;
-    int rowDiff = to.row - from.row;
-    int colDiff = abs(to.col - from.col);
-    
-    // Forward movement
-    if (colDiff == 0) {
-        // Single square forward
-        if (rowDiff == direction && !board.getPiece(to)) return true;
-        
-        // Two squares forward from starting position
-        if (!hasMoved && rowDiff == 2 * direction && 
-            !board.getPiece(to) && 
-            !board.getPiece(Position(from.row + direction, from.col))) {
-            return true;
+bool Piece::isValidMove(const Position& from, const Position& to, const Board& board) const {
+    int fromSq = makeSquare(from.row, from.col);
+    Bitboard target = squareBB(makeSquare(to.row, to.col));
+    const Piece* targetPiece = board.getPiece(to);
+    bool white = isWhite();
+
+    switch (type()) {
+        case PAWN: {
+            int direction = white ? 1 : -1;
+            int rowDiff = to.row - from.row;
+            int colDiff = abs(to.col - from.col);
+
+            // Forward movement
+            if (colDiff == 0) {
+                // Single square forward
+                if (rowDiff == direction && !targetPiece) return true;
+
+                // Two squares forward from starting position
+                int startRow = white ? 1 : 6;
+                return from.row == startRow && rowDiff == 2 * direction && !targetPiece &&
+                       !board.getPiece(Position(from.row + direction, from.col));
+            }
+            // Capture diagonally
+            return colDiff == 1 && rowDiff == direction && targetPiece && targetPiece->isWhite() != white;
         }
-    }
-    // Capture diagonally
-    else if (colDiff == 1 && rowDiff == direction) {
-        const auto& targetPiece = board.getPiece(to);
-        return targetPiece && targetPiece->isWhite() != white;
-    }
-    
-    return false;
-}
 
-// Rook movement
-bool Rook::isValidMove(const Position& from, const Position& to, const Board& board) const {
-    if (from.row != to.row && from.col != to.col) return false;
-    
-    const auto& targetPiece = board.getPiece(to);
-    if (targetPiece && targetPiece->isWhite() == white) return false;
-    
-    return isPathClear(from, to, board);
-}
+        case KING:
+            // Castling is checked by the board
+            if (to.row == from.row && abs(to.col - from.col) == 2) {
+                return board.canCastle(from, to);
+            }
+            if (!(kingAttacks(fromSq) & target)) return false;
+            break;
 
-// Knight movement
-bool Knight::isValidMove(const Position& from, const Position& to, const Board& board) const {
-    int rowDiff = abs(to.row - from.row);
-    int colDiff = abs(to.col - from.col);
-    
-    if (!((rowDiff == 2 && colDiff == 1) || (rowDiff == 1 && colDiff == 2))) return false;
-    
-    const auto& targetPiece = board.getPiece(to);
-    return !targetPiece || targetPiece->isWhite() != white;
-}
+        case KNIGHT:
+            if (!(knightAttacks(fromSq) & target)) return false;
+            break;
 
-// Bishop movement
-bool Bishop::isValidMove(const Position& from, const Position& to, const Board& board) const {
-    int rowDiff = abs(to.row - from.row);
-    int colDiff = abs(to.col - from.col);
-    
-    if (rowDiff != colDiff) return false;
-    
-    const auto& targetPiece = board.getPiece(to);
-    if (targetPiece && targetPiece->isWhite() == white) return false;
-    
-    return isPathClear(from, to, board);
-}
+        case BISHOP:
+            if (!(bishopAttacks(fromSq, board.occupancy()) & target)) return false;
+            break;
 
-// Queen movement
-bool Queen::isValidMove(const Position& from, const Position& to, const Board& board) const {
-    int rowDiff = abs(to.row - from.row);
-    int colDiff = abs(to.col - from.col);
-    
-    // Move like rook or bishop
-    if (!((from.row == to.row || from.col == to.col) || (rowDiff == colDiff))) return false;
-    
-    const auto& targetPiece = board.getPiece(to);
-    if (targetPiece && targetPiece->isWhite() == white) return false;
-    
-    return isPathClear(from, to, board);
-}
+        case ROOK:
+            if (!(rookAttacks(fromSq, board.occupancy()) & target)) return false;
+            break;
 
-// King movement
-bool King::isValidMove(const Position& from, const Position& to, const Board& board) const {
-    int rowDiff = abs(to.row - from.row);
-    int colDiff = abs(to.col - from.col);
-    
-    // Normal one square movement
-    if (rowDiff <= 1 && colDiff <= 1) {
-        const auto& targetPiece = board.getPiece(to);
-        return !targetPiece || targetPiece->isWhite() != white;
-    }
-    
-    // Castling
-    if (!hasMoved() && rowDiff == 0 && colDiff == 2) {
-        // Check if it's a valid castling move (implemented in Board class)
-        return board.canCastle(from, to);
+        case QUEEN:
+            if (!(queenAttacks(fromSq, board.occupancy()) & target)) return false;
+            break;
+
+        default:
+            return false;
     }
-    
-    return false;
-}
\ No newline at end of file
+    return !targetPiece || targetPiece->isWhite() != white;
+}
@@ -2,76 +2,68 @@
 #define PIECE_H
 
 #include "position.h"
-#include <memory>
+#include "Bitboard.h"
+#include <cstdint>
 
 class Board; // Forward declaration
 
+// A piece as a single byte: kind in the low three bits, color in bit 3.
+// NO_PIECE_TYPE marks an empty square, so a board's mailbox is a plain
+// 64-byte array that copies with the rest of the position.
 class Piece {
 protected:
-    bool white;      // true for white pieces, false for black
-    char symbol;     // P=pawn, R=rook, N=knight, B=bishop, Q=queen, K=king
+    uint8_t code;
 
 public:
-    Piece(bool isWhite, char sym) : white(isWhite), symbol(sym) {}
-    virtual ~Piece() = default;
-    
-    bool isWhite() const { return white; }
-    char getSymbol() const { return symbol; }
-    
-    virtual bool isValidMove(const Position& from, const Position& to, const Board& board) const = 0;
-    virtual std::unique_ptr<Piece> clone() const = 0;  // Add this line
+    constexpr Piece() : code(NO_PIECE_TYPE) {}
+    constexpr Piece(Color color, PieceType type) : code(static_cast<uint8_t>(color << 3 | type)) {}
+    Piece(bool isWhite, char sym);
+
+    bool isEmpty() const { return type() == NO_PIECE_TYPE; }
+    PieceType type() const { return static_cast<PieceType>(code & 7); }
+    Color color() const { return static_cast<Color>(code >> 3); }
+    bool isWhite() const { return color() == WHITE; }
+    char getSymbol() const { return "PNBRQK "[type()]; }
+
+    // Movement rules, dispatched on the kind rather than through a vtable
+    bool isValidMove(const Position& from, const Position& to, const Board& board) const;
+    Piece clone() const { return *this; }
+
+    bool operator==(const Piece& other) const { return code == other.code; }
+    bool operator!=(const Piece& other) const { return code != other.code; }
 };
 
-class Pawn : public Piece {
-private:
-    bool hasMoved;
+static_assert(sizeof(Piece) == 1, "Piece must stay one byte");
 
+// Named views of each kind, kept so existing code can still write Pawn(true)
+class Pawn : public Piece {
 public:
-    Pawn(bool isWhite) : Piece(isWhite, 'P'), hasMoved(false) {}
-    bool isValidMove(const Position& from, const Position& to, const Board& board) const override;
-    std::unique_ptr<Piece> clone() const override { return std::make_unique<Pawn>(*this); }
+    Pawn(bool isWhite) : Piece(isWhite ? WHITE : BLACK, PAWN) {}
 };
 
 class Rook : public Piece {
-    private:
-        bool _hasMoved;
-    public:
-        Rook(bool isWhite) : Piece(isWhite, 'R') {}
-        bool isValidMove(const Position& from, const Position& to, const Board& board) const override;
-        bool hasMoved() const { return _hasMoved; }
-        std::unique_ptr<Piece> clone() const override { return std::make_unique<Rook>(*this); }
+public:
+    Rook(bool isWhite) : Piece(isWhite ? WHITE : BLACK, ROOK) {}
 };
 
 class Knight : public Piece {
 public:
-    Knight(bool isWhite) : Piece(isWhite, 'N') {}
-    bool isValidMove(const Position& from, const Position& to, const Board& board) const override;
-    std::unique_ptr<Piece> clone() const override { return std::make_unique<Knight>(*this); }
+    Knight(bool isWhite) : Piece(isWhite ? WHITE : BLACK, KNIGHT) {}
 };
 
 class Bishop : public Piece {
 public:
-    Bishop(bool isWhite) : Piece(isWhite, 'B') {}
-    bool isValidMove(const Position& from, const Position& to, const Board& board) const override;
-    std::unique_ptr<Piece> clone() const override { return std::make_unique<Bishop>(*this); }
+    Bishop(bool isWhite) : Piece(isWhite ? WHITE : BLACK, BISHOP) {}
 };
 
 class Queen : public Piece {
 public:
-    Queen(bool isWhite) : Piece(isWhite, 'Q') {}
-    bool isValidMove(const Position& from, const Position& to, const Board& board) const override;
-    std::unique_ptr<Piece> clone() const override { return std::make_unique<Queen>(*this); }
+    Queen(bool isWhite) : Piece(isWhite ? WHITE : BLACK, QUEEN) {}
 };
 
 class King : public Piece {
-private:
-    bool _hasMoved;
-
 public:
-    King(bool isWhite) : Piece(isWhite, 'K'), _hasMoved(false) {}
-    bool isValidMove(const Position& from, const Position& to, const Board& board) const override;
-    bool hasMoved() const { return _hasMoved; }
-    std::unique_ptr<Piece> clone() const override { return std::make_unique<King>(*this); }
+    King(bool isWhite) : Piece(isWhite ? WHITE : BLACK, KING) {}
 };
 
-#endif // PIECE_H
\ No newline at end of file
+#endif // PIECE_H
@@ -0,0 +1,167 @@
+#ifndef PSQT_H
+#define PSQT_H
+
+#include "Bitboard.h"
+
+// An evaluation term with separate middlegame and endgame values, blended by
+// game phase when the position is evaluated
+struct Score {
+    int mg;
+    int eg;
+
+    constexpr Score operator+(Score other) const { return Score{mg + other.mg, eg + other.eg}; }
+    constexpr Score operator-(Score other) const { return Score{mg - other.mg, eg - other.eg}; }
+    constexpr Score operator-() const { return Score{-mg, -eg}; }
+    constexpr Score operator*(int n) const { return Score{mg * n, eg * n}; }
+    Score& operator+=(Score other) { mg += other.mg; eg += other.eg; return *this; }
+    Score& operator-=(Score other) { mg -= other.mg; eg -= other.eg; return *this; }
+};
+
+// Material in centipawns, indexed by PieceType
+constexpr Score MATERIAL[6] = { {100, 120}, {320, 290}, {330, 310}, {500, 540}, {900, 950}, {0, 0} };
+
+// Game phase contributed by each piece; 24 with all pieces on the board
+constexpr int PHASE_WEIGHT[6] = { 0, 1, 1, 2, 4, 0 };
+const int MAX_PHASE = 24;
+
+// Piece-square bonuses from White's point of view, written with rank 8 on top
+// so they read like the board. Kings and pawns change role in the endgame and
+// have separate tables there.
+constexpr int PSQT_MG[6][64] = {
+    { // Pawn
+         0,   0,   0,   0,   0,   0,   0,   0,
+        50,  50,  50,  50,  50,  50,  50,  50,
+        10,  10,  20,  30,  30,  20,  10,  10,
+         5,   5,  10,  25,  25,  10,   5,   5,
+         0,   0,   0,  20,  20,   0,   0,   0,
+         5,  -5, -10,   0,   0, -10,  -5,   5,
+         5,  10,  10, -20, -20,  10,  10,   5,
+         0,   0,   0,   0,   0,   0,   0,   0 },
+    { // Knight
+       -50, -40, -30, -30, -30, -30, -40, -50,
+       -40, -20,   0,   0,   0,   0, -20, -40,
+       -30,   0,  10,  15,  15,  10,   0, -30,
+       -30,   5,  15,  20,  20,  15,   5, -30,
+       -30,   0,  15,  20,  20,  15,   0, -30,
+       -30,   5,  10,  15,  15,  10,   5, -30,
+       -40, -20,   0,   5,   5,   0, -20, -40,
+       -50, -40, -30, -30, -30, -30, -40, -50 },
+    { // Bishop
+       -20, -10, -10, -10, -10, -10, -10, -20,
+       -10,   0,   0,   0,   0,   0,   0, -10,
+       -10,   0,   5,  10,  10,   5,   0, -10,
+       -10,   5,   5,  10,  10,   5,   5, -10,
+       -10,   0,  10,  10,  10,  10,   0, -10,
+       -10,  10,  10,  10,  10,  10,  10, -10,
+       -10,   5,   0,   0,   0,   0,   5, -10,
+       -20, -10, -10, -10, -10, -10, -10, -20 },
+    { // Rook
+         0,   0,   0,   0,   0,   0,   0,   0,
+         5,  10,  10,  10,  10,  10,  10,   5,
+        -5,   0,   0,   0,   0,   0,   0,  -5,
+        -5,   0,   0,   0,   0,   0,   0,  -5,
+        -5,   0,   0,   0,   0,   0,   0,  -5,
+        -5,   0,   0,   0,   0,   0,   0,  -5,
+        -5,   0,   0,   0,   0,   0,   0,  -5,
+         0,   0,   0,   5,   5,   0,   0,   0 },
+    { // Queen
+       -20, -10, -10,  -5,  -5, -10, -10, -20,
+       -10,   0,   0,   0,   0,   0,   0, -10,
+       -10,   0,   5,   5,   5,   5,   0, -10,
+        -5,   0,   5,   5,   5,   5,   0,  -5,
+         0,   0,   5,   5,   5,   5,   0,  -5,
+       -10,   5,   5,   5,   5,   5,   0, -10,
+       -10,   0,   5,   0,   0,   0,   0, -10,
+       -20, -10, -10,  -5,  -5, -10, -10, -20 },
+    { // King
+       -30, -40, -40, -50, -50, -40, -40, -30,
+       -30, -40, -40, -50, -50, -40, -40, -30,
+       -30, -40, -40, -50, -50, -40, -40, -30,
+       -30, -40, -40, -50, -50, -40, -40, -30,
+       -20, -30, -30, -40, -40, -30, -30, -20,
+       -10, -20, -20, -20, -20, -20, -20, -10,
+        20,  20,   0,   0,   0,   0,  20,  20,
+        20,  30,  10,   0,   0,  10,  30,  20 }
+};
+
+constexpr int PSQT_EG[6][64] = {
+    { // Pawn: advancing matters more than the file
+         0,   0,   0,   0,   0,   0,   0,   0,
+        80,  80,  80,  80,  80,  80,  80,  80,
+        50,  50,  50,  50,  50,  50,  50,  50,
+        30,  30,  30,  30,  30,  30,  30,  30,
+        15,  15,  15,  15,  15,  15,  15,  15,
+         5,   5,   5,   5,   5,   5,   5,   5,
+         0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0 },
+    { // Knight
+       -50, -40, -30, -30, -30, -30, -40, -50,
+       -40, -20,   0,   0,   0,   0, -20, -40,
+       -30,   0,  10,  15,  15,  10,   0, -30,
+       -30,   5,  15,  20,  20,  15,   5, -30,
+       -30,   0,  15,  20,  20,  15,   0, -30,
+       -30,   5,  10,  15,  15,  10,   5, -30,
+       -40, -20,   0,   5,   5,   0, -20, -40,
+       -50, -40, -30, -30, -30, -30, -40, -50 },
+    { // Bishop
+       -20, -10, -10, -10, -10, -10, -10, -20,
+       -10,   0,   0,   0,   0,   0,   0, -10,
+       -10,   0,   5,  10,  10,   5,   0, -10,
+       -10,   5,   5,  10,  10,   5,   5, -10,
+       -10,   0,  10,  10,  10,  10,   0, -10,
+       -10,  10,  10,  10,  10,  10,  10, -10,
+       -10,   5,   0,   0,   0,   0,   5, -10,
+       -20, -10, -10, -10, -10, -10, -10, -20 },
+    { // Rook
+         0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0 },
+    { // Queen
+       -20, -10, -10,  -5,  -5, -10, -10, -20,
+       -10,   0,   0,   0,   0,   0,   0, -10,
+       -10,   0,   5,   5,   5,   5,   0, -10,
+        -5,   0,   5,   5,   5,   5,   0,  -5,
+        -5,   0,   5,   5,   5,   5,   0,  -5,
+       -10,   0,   5,   5,   5,   5,   0, -10,
+       -10,   0,   0,   0,   0,   0,   0, -10,
+       -20, -10, -10,  -5,  -5, -10, -10, -20 },
+    { // King: centralize once the queens are gone
+       -50, -40, -30, -20, -20, -30, -40, -50,
+       -30, -20, -10,   0,   0, -10, -20, -30,
+       -30, -10,  20,  30,  30,  20, -10, -30,
+       -30, -10,  30,  40,  40,  30, -10, -30,
+       -30, -10,  30,  40,  40,  30, -10, -30,
+       -30, -10,  20,  30,  30,  20, -10, -30,
+       -30, -30,   0,   0,   0,   0, -30, -30,
+       -50, -30, -30, -30, -30, -30, -30, -50 }
+};
+
+// Material plus piece-square bonus for every piece on every square, signed
+// so White's pieces count positive. Board adds and subtracts these as pieces
+// move, so the sum is always current.
+struct PsqtTable {
+    Score values[2][6][64];
+};
+
+constexpr PsqtTable makePsqt() {
+    PsqtTable table{};
+    for (int t = 0; t < 6; t++) {
+        for (int sq = 0; sq < 64; sq++) {
+            // The tables have rank 8 first; Black sees them mirrored
+            int whiteIndex = makeSquare(7 - rowOf(sq), colOf(sq));
+            int blackIndex = sq;
+            table.values[WHITE][t][sq] = MATERIAL[t] + Score{PSQT_MG[t][whiteIndex], PSQT_EG[t][whiteIndex]};
+            table.values[BLACK][t][sq] = -(MATERIAL[t] + Score{PSQT_MG[t][blackIndex], PSQT_EG[t][blackIndex]});
+        }
+    }
+    return table;
+}
+
+inline constexpr PsqtTable PSQT = makePsqt();
+
+#endif // PSQT_H
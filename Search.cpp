@@ -0,0 +1,344 @@
+#include "Search.h"
+#include "Evaluate.h"
+#include "Tablebase.h"
+#include <algorithm>
+#include <thread>
+
+// Mate scores are stored relative to the node rather than the root so they
+// stay correct when the entry is found at a different ply
+static int scoreToTT(int score, int ply) {
+    if (score >= MATE_BOUND) return score + ply;
+    if (score <= -MATE_BOUND) return score - ply;
+    return score;
+}
+
+static int scoreFromTT(int score, int ply) {
+    if (score >= MATE_BOUND) return score - ply;
+    if (score <= -MATE_BOUND) return score + ply;
+    return score;
+}
+
+SearchWorker::SearchWorker(Search& owner, int workerId)
+    : nodes(0), search(owner), id(workerId), betaCutoffs(0), firstMoveCutoffs(0), useNetwork(false) {}
+
+void SearchWorker::start(const Board& position) {
+    board = position;
+    nodes = 0;
+    result = SearchResult();
+
+    // Earlier positions a reversible line could return to
+    const std::vector<uint64_t>& game = search.gameKeys;
+    rootIndex = 0;
+    if (!game.empty()) {
+        rootIndex = std::min({static_cast<int>(game.size()) - 1, board.getHalfmoveClock(), MAX_GAME_PLIES});
+        std::copy(game.end() - 1 - rootIndex, game.end() - 1, keys);
+    }
+    keys[rootIndex] = board.hash();
+    for (auto& slots : killers) {
+        slots[0] = slots[1] = NO_MOVE;
+    }
+    history.clear();
+    betaCutoffs = 0;
+    firstMoveCutoffs = 0;
+
+    useNetwork = search.useNetwork && nnueNetwork.isLoaded();
+    if (useNetwork) {
+        nnueNetwork.refresh(board, accumulators[0]);
+    }
+}
+
+int SearchWorker::staticEval(int ply) const {
+    if (useNetwork) {
+        return nnueNetwork.evaluate(accumulators[ply], board.isWhiteTurn ? WHITE : BLACK);
+    }
+    return evaluate(board);
+}
+
+// doMove plus the network accumulator of the new position
+void SearchWorker::makeMove(Move move, UndoInfo& undo, int ply) {
+    board.doMove(move, undo);
+    if (useNetwork) {
+        nnueNetwork.update(board, undo, accumulators[ply], accumulators[ply + 1]);
+    }
+}
+
+void SearchWorker::countNode() {
+    uint64_t n = nodes.load(std::memory_order_relaxed) + 1;
+    nodes.store(n, std::memory_order_relaxed);
+    if (id == 0 && (n & 2047) == 0) {
+        search.checkLimits();
+    }
+}
+
+// A position already seen in the game or on the current line is scored as a
+// draw. Only positions since the last capture or pawn move can repeat, and
+// the same side is to move only an even number of plies back.
+bool SearchWorker::isRepetition(int ply) const {
+    int current = rootIndex + ply;
+    int oldest = std::max(0, current - board.getHalfmoveClock());
+    for (int i = current - 4; i >= oldest; i -= 2) {
+        if (keys[i] == keys[current]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A quiet move that caused a cutoff becomes the first killer at its ply and
+// gains history; the quiet moves searched before it without a cutoff lose some
+void SearchWorker::updateQuietStats(Move best, const Move* tried, int triedCount, int depth, int ply) {
+    if (killers[ply][0] != best) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = best;
+    }
+
+    Color us = board.isWhiteTurn ? WHITE : BLACK;
+    int bonus = depth * depth;
+    history.update(us, best, bonus);
+    for (int i = 0; i < triedCount; i++) {
+        history.update(us, tried[i], -bonus);
+    }
+}
+
+int SearchWorker::quiescence(int alpha, int beta, int ply) {
+    pvLength[ply] = ply;
+    countNode();
+    if (search.stopped) return 0;
+    if (ply >= MAX_PLY - 1) return staticEval(ply);
+
+    // In check every evasion is searched; otherwise the side to move may
+    // stand pat on the static score
+    bool inCheck = board.isInCheck(board.isWhiteTurn);
+    if (!inCheck) {
+        int standPat = staticEval(ply);
+        if (standPat >= beta) return standPat;
+        if (standPat > alpha) alpha = standPat;
+    }
+
+    // Captures that do not lose material, or every evasion when in check
+    MovePicker picker(board, history, inCheck);
+    int bestScore = inCheck ? -INFINITE_SCORE : alpha;
+    Move move;
+    while ((move = picker.next()) != NO_MOVE) {
+        UndoInfo undo;
+        makeMove(move, undo, ply);
+        int score = -quiescence(-beta, -alpha, ply + 1);
+        board.undoMove(undo);
+        if (search.stopped) return 0;
+
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) break;
+            }
+        }
+    }
+    if (inCheck && bestScore == -INFINITE_SCORE) {
+        return -MATE_SCORE + ply;
+    }
+    return bestScore;
+}
+
+int SearchWorker::negamax(int depth, int alpha, int beta, int ply) {
+    pvLength[ply] = ply;
+    if (ply > 0 && isRepetition(ply)) return 0;
+
+    // Endings the tablebases cover need no search below the root
+    int wdl, plies;
+    if (ply > 0 && popCount(board.occupancy()) <= tablebases.maxPieces() && tablebases.probe(board, wdl, plies)) {
+        if (wdl > 0) return MATE_SCORE - ply - plies;
+        if (wdl < 0) return -MATE_SCORE + ply + plies;
+        return 0;
+    }
+
+    bool inCheck = board.isInCheck(board.isWhiteTurn);
+    if (inCheck) depth++;  // Check extension
+    if (depth <= 0) return quiescence(alpha, beta, ply);
+
+    countNode();
+    if (search.stopped) return 0;
+    if (ply >= MAX_PLY - 1) return staticEval(ply);
+
+    // Outside the principal variation a deep enough stored bound ends the node
+    bool pvNode = beta - alpha > 1;
+    TTData entry;
+    Move ttMove = NO_MOVE;
+    if (search.tt.probe(board.hash(), entry)) {
+        ttMove = entry.move;
+        int ttScore = scoreFromTT(entry.score, ply);
+        if (!pvNode && ply > 0 && entry.depth >= depth &&
+            (entry.bound == BOUND_EXACT ||
+             (entry.bound == BOUND_LOWER && ttScore >= beta) ||
+             (entry.bound == BOUND_UPPER && ttScore <= alpha))) {
+            return ttScore;
+        }
+    }
+
+    MovePicker picker(board, ttMove, killers[ply], history);
+    int originalAlpha = alpha;
+    int bestScore = -INFINITE_SCORE;
+    Move bestMove = NO_MOVE;
+    int moveCount = 0;
+    Move quietsTried[64];
+    int quietCount = 0;
+    Move move;
+    while ((move = picker.next()) != NO_MOVE) {
+        bool quiet = !board.isCapture(move) && moveKind(move) != PROMOTION;
+        UndoInfo undo;
+        makeMove(move, undo, ply);
+        keys[rootIndex + ply + 1] = board.hash();
+        moveCount++;
+
+        // Principal variation search: later moves get a null window first
+        int score;
+        if (moveCount == 1) {
+            score = -negamax(depth - 1, -beta, -alpha, ply + 1);
+        } else {
+            score = -negamax(depth - 1, -alpha - 1, -alpha, ply + 1);
+            if (score > alpha && score < beta) {
+                score = -negamax(depth - 1, -beta, -alpha, ply + 1);
+            }
+        }
+        board.undoMove(undo);
+        if (search.stopped) return 0;
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = move;
+            if (score > alpha) {
+                alpha = score;
+
+                // Extend the principal variation with the child's line
+                pvTable[ply][ply] = move;
+                for (int j = ply + 1; j < pvLength[ply + 1]; j++) {
+                    pvTable[ply][j] = pvTable[ply + 1][j];
+                }
+                pvLength[ply] = pvLength[ply + 1];
+
+                if (alpha >= beta) {
+                    betaCutoffs++;
+                    if (moveCount == 1) firstMoveCutoffs++;
+                    if (quiet) updateQuietStats(move, quietsTried, quietCount, depth, ply);
+                    break;
+                }
+            }
+        }
+        if (quiet && quietCount < 64) {
+            quietsTried[quietCount++] = move;
+        }
+    }
+
+    if (moveCount == 0) {
+        return inCheck ? -MATE_SCORE + ply : 0;
+    }
+
+    Bound bound = (bestScore >= beta) ? BOUND_LOWER
+                : (bestScore > originalAlpha) ? BOUND_EXACT : BOUND_UPPER;
+    search.tt.store(board.hash(), bestMove, scoreToTT(bestScore, ply), depth, bound);
+    return bestScore;
+}
+
+void SearchWorker::iterate() {
+    // Any legal move is better than none if the first iteration is cut short
+    {
+        MoveList rootMoves;
+        board.generateLegalMoves(board.isWhiteTurn ? WHITE : BLACK, rootMoves);
+        if (rootMoves.empty()) {
+            return;
+        }
+        result.bestMove = rootMoves[0];
+    }
+
+    for (int depth = 1; depth <= search.limits.depth && depth < MAX_PLY; depth++) {
+        // Helpers with odd ids run a ply ahead so threads spread over depths
+        int searchDepth = (id & 1) ? depth + 1 : depth;
+        int score = negamax(searchDepth, -INFINITE_SCORE, INFINITE_SCORE, 0);
+
+        // An interrupted iteration is only trusted for the first depth
+        if (search.stopped && result.depth > 0) break;
+
+        if (pvLength[0] > 0) {
+            result.bestMove = pvTable[0][0];
+            result.pv.assign(pvTable[0], pvTable[0] + pvLength[0]);
+        }
+        result.score = score;
+        result.depth = depth;
+
+        if (id == 0) {
+            result.nodes = search.totalNodes();
+            result.milliseconds = search.elapsed();
+            result.hashfull = search.tt.hashfull();
+            result.betaCutoffs = betaCutoffs;
+            result.firstMoveCutoffs = firstMoveCutoffs;
+            if (search.onIteration) search.onIteration(result);
+        }
+        if (search.stopped) break;
+
+        // No point searching deeper once a forced mate is found
+        if (score >= MATE_SCORE - depth || score <= -MATE_SCORE + depth) break;
+    }
+}
+
+Search::Search(size_t hashMegabytes) : tt(hashMegabytes), stopped(false), threadCount(1), useNetwork(false) {}
+
+void Search::setThreads(int count) {
+    threadCount = count < 1 ? 1 : count;
+}
+
+int64_t Search::elapsed() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+}
+
+uint64_t Search::totalNodes() const {
+    uint64_t total = 0;
+    for (const auto& worker : workers) {
+        total += worker->nodes.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void Search::checkLimits() {
+    if ((limits.nodes && totalNodes() >= limits.nodes) ||
+        (limits.moveTime && elapsed() >= limits.moveTime)) {
+        stopped = true;
+    }
+}
+
+SearchResult Search::think(const Board& board, const SearchLimits& searchLimits, InfoCallback callback,
+                           const std::vector<uint64_t>& history) {
+    limits = searchLimits;
+    onIteration = callback;
+    gameKeys = history;
+    startTime = std::chrono::steady_clock::now();
+    stopped = false;
+    tt.newSearch();
+
+    while (static_cast<int>(workers.size()) < threadCount) {
+        workers.emplace_back(new SearchWorker(*this, static_cast<int>(workers.size())));
+    }
+    workers.resize(threadCount);
+    for (auto& worker : workers) {
+        worker->start(board);
+    }
+
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < threadCount; i++) {
+        helpers.emplace_back(&SearchWorker::iterate, workers[i].get());
+    }
+
+    workers[0]->iterate();
+
+    // Helpers keep going until the main thread is done
+    stopped = true;
+    for (auto& t : helpers) {
+        t.join();
+    }
+
+    SearchResult result = workers[0]->result;
+    result.nodes = totalNodes();
+    result.milliseconds = elapsed();
+    result.hashfull = tt.hashfull();
+    return result;
+}
@@ -0,0 +1,144 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "Board.h"
+#include "Move.h"
+#include "MovePicker.h"
+#include "Nnue.h"
+#include "TranspositionTable.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+const int MAX_PLY = 64;
+const int MATE_SCORE = 32000;       // Score for delivering mate at the root
+const int MATE_BOUND = MATE_SCORE - 1000;  // Scores beyond this are mates; tablebase mates can be
+                                           // much longer than MAX_PLY
+const int INFINITE_SCORE = 32001;
+
+// Game positions before the root kept for repetition checks; after 100
+// plies without a capture or pawn move the game is drawn anyway
+const int MAX_GAME_PLIES = 100;
+
+// When to stop thinking. Zero means no limit for nodes and moveTime.
+struct SearchLimits {
+    int depth = MAX_PLY - 1;
+    uint64_t nodes = 0;
+    int moveTime = 0;               // Milliseconds
+};
+
+struct SearchResult {
+    Move bestMove = NO_MOVE;
+    int score = 0;                  // Centipawns for the side to move
+    int depth = 0;                  // Last completed iteration
+    uint64_t nodes = 0;
+    int64_t milliseconds = 0;
+    int hashfull = 0;               // Permille of the transposition table in use
+    std::vector<Move> pv;
+
+    // Move ordering quality on the main thread: how many beta cutoffs there
+    // were and how many of them came from the first move searched
+    uint64_t betaCutoffs = 0;
+    uint64_t firstMoveCutoffs = 0;
+
+    uint64_t nps() const { return milliseconds > 0 ? nodes * 1000 / milliseconds : nodes * 1000; }
+    double firstMoveCutoffRate() const { return betaCutoffs ? 100.0 * firstMoveCutoffs / betaCutoffs : 0.0; }
+};
+
+class Search;
+
+// The state one search thread owns. Setting one up is a flat Board copy plus
+// a few small tables, so helpers can be started for every search.
+class SearchWorker {
+public:
+    SearchWorker(Search& owner, int id);
+
+    void start(const Board& position);
+    void iterate();
+
+    SearchResult result;
+    std::atomic<uint64_t> nodes;
+
+private:
+    Search& search;
+    int id;                         // 0 is the main thread
+    Board board;
+
+    Move pvTable[MAX_PLY][MAX_PLY];
+    int pvLength[MAX_PLY];
+    // Position hashes of the game since the last capture or pawn move and
+    // then along the current line; the root is at keys[rootIndex]
+    uint64_t keys[MAX_GAME_PLIES + MAX_PLY + 1];
+    int rootIndex;
+
+    // Move ordering state: quiet moves that caused a cutoff at each ply, and
+    // cutoff history by from/to square
+    Move killers[MAX_PLY][2];
+    HistoryTable history;
+    uint64_t betaCutoffs;
+    uint64_t firstMoveCutoffs;
+
+    // Network accumulators along the current line, when evaluating with NNUE
+    bool useNetwork;
+    Accumulator accumulators[MAX_PLY + 1];
+
+    int negamax(int depth, int alpha, int beta, int ply);
+    int quiescence(int alpha, int beta, int ply);
+    int staticEval(int ply) const;
+    void makeMove(Move move, UndoInfo& undo, int ply);
+    void updateQuietStats(Move best, const Move* tried, int triedCount, int depth, int ply);
+    bool isRepetition(int ply) const;
+    void countNode();
+};
+
+// Negamax alpha-beta with iterative deepening, a capture-only quiescence
+// search at the horizon and a triangular principal variation table.
+//
+// With more than one thread the search is Lazy SMP: helper threads search
+// the same root, odd-numbered ones a ply deeper, and share what they find
+// through the transposition table. The main thread's result is reported.
+class Search {
+public:
+    // Called after every completed iteration with the result so far
+    typedef std::function<void(const SearchResult&)> InfoCallback;
+
+    explicit Search(size_t hashMegabytes = 16);
+
+    void setThreads(int count);
+    void setHashSize(size_t megabytes) { tt.resize(megabytes); }
+    void clearHash() { tt.clear(); }
+
+    // Evaluate with the loaded network instead of the handcrafted terms
+    void setUseNetwork(bool enabled) { useNetwork = enabled; }
+
+    // gameKeys holds the hashes of the game's positions, oldest first and
+    // ending with `board` itself. Lines returning to one of them score as
+    // draws, so the engine sees repetitions of the game as well as its own.
+    SearchResult think(const Board& board, const SearchLimits& limits, InfoCallback onIteration = nullptr,
+                       const std::vector<uint64_t>& gameKeys = {});
+
+    // Safe to call from another thread; think() returns with the best move so far
+    void stop() { stopped = true; }
+
+private:
+    friend class SearchWorker;
+
+    TranspositionTable tt;
+    SearchLimits limits;
+    InfoCallback onIteration;
+    std::vector<uint64_t> gameKeys;
+    std::chrono::steady_clock::time_point startTime;
+    std::atomic<bool> stopped;
+    int threadCount;
+    bool useNetwork;
+    std::vector<std::unique_ptr<SearchWorker>> workers;
+
+    uint64_t totalNodes() const;
+    void checkLimits();
+    int64_t elapsed() const;
+};
+
+#endif // SEARCH_H
@@ -0,0 +1,330 @@
+#include "Server.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+
+static int64_t nowNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void GameRecord::pack(const Board& board) {
+    std::memset(squares, 0, sizeof(squares));
+    for (int c = 0; c < 2; c++) {
+        for (int t = PAWN; t <= KING; t++) {
+            Bitboard b = board.piecesOf(static_cast<Color>(c), static_cast<PieceType>(t));
+            while (b) {
+                int sq = popLsb(b);
+                squares[sq / 2] |= static_cast<uint8_t>((1 + t + 8 * c) << (4 * (sq & 1)));
+            }
+        }
+    }
+    fullmoveNumber = static_cast<uint16_t>(board.getFullmoveNumber());
+    halfmoveClock = static_cast<uint8_t>(std::min(board.getHalfmoveClock(), 255));
+    castlingRights = static_cast<uint8_t>(board.getCastlingRights());
+    enPassantSquare = static_cast<int8_t>(board.getEnPassantSquare());
+    flags = static_cast<uint8_t>((flags & ~WHITE_TO_MOVE) | (board.isWhiteTurn ? WHITE_TO_MOVE : 0));
+}
+
+void GameRecord::unpack(Board& board) const {
+    PiecePlacement placements[32];
+    int count = 0;
+    for (int sq = 0; sq < 64 && count < 32; sq++) {
+        int code = (squares[sq / 2] >> (4 * (sq & 1))) & 15;
+        if (code) {
+            placements[count++] = PiecePlacement{ static_cast<Color>(code >> 3),
+                                                  static_cast<PieceType>((code & 7) - 1), sq };
+        }
+    }
+    board.setPosition(placements, count, (flags & WHITE_TO_MOVE) != 0, castlingRights, enPassantSquare,
+                      halfmoveClock, fullmoveNumber);
+}
+
+GameServer::GameServer(int threads, uint32_t capacity, std::function<void(const std::string&)> send)
+    : slab(capacity), open(capacity, false), latency(LATENCY_BUCKETS), send(std::move(send)), pool(threads) {
+    // Lowest ids are handed out first
+    freeSlots.reserve(capacity);
+    for (uint32_t i = capacity; i > 0; i--) {
+        freeSlots.push_back(i - 1);
+    }
+    for (auto& bucket : latency) {
+        bucket = 0;
+    }
+}
+
+void GameServer::reply(const std::string& line, int64_t arrival) {
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        send(line);
+    }
+    int64_t micros = (nowNanoseconds() - arrival) / 1000;
+    latency[std::min<int64_t>(std::max<int64_t>(micros, 0), LATENCY_BUCKETS - 1)]++;
+}
+
+uint64_t GameServer::requestCount() const {
+    uint64_t total = 0;
+    for (const auto& bucket : latency) total += bucket.load();
+    return total;
+}
+
+double GameServer::latencyPercentile(double fraction) const {
+    uint64_t total = requestCount();
+    if (total == 0) return 0;
+    uint64_t target = static_cast<uint64_t>(fraction * (total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += latency[i].load();
+        if (seen >= target) return i;
+    }
+    return LATENCY_BUCKETS - 1;
+}
+
+std::string GameServer::statsLine() const {
+    int highest = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        if (latency[i].load()) highest = i;
+    }
+    std::ostringstream out;
+    out << "stats games " << liveGames() << " bytes/game " << bytesPerGame() << " requests " << requestCount()
+        << " p50 " << latencyPercentile(0.5) << "us p99 " << latencyPercentile(0.99) << "us max "
+        << highest << (highest == LATENCY_BUCKETS - 1 ? "+" : "") << "us";
+    return out.str();
+}
+
+void GameServer::enqueue(uint32_t id, const Request& request) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        auto it = queuedRequests.find(id);
+        if (it != queuedRequests.end()) {
+            // A task for this game is already queued or running and will
+            // pick the request up
+            it->second.push_back(request);
+            return;
+        }
+        queuedRequests[id].push_back(request);
+    }
+    pool.submit([this, id]() { runGame(id); });
+}
+
+void GameServer::runGame(uint32_t id) {
+    for (;;) {
+        Request request;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            auto it = queuedRequests.find(id);
+            if (it->second.empty()) {
+                queuedRequests.erase(it);
+                return;
+            }
+            request = it->second.front();
+            it->second.pop_front();
+        }
+        execute(id, request);
+    }
+}
+
+// Runs on a pool thread; only one task at a time touches a given record
+void GameServer::execute(uint32_t id, const Request& request) {
+    std::string prefix = std::to_string(id);
+    GameRecord& record = slab[id];
+    Board board;
+    switch (request.kind) {
+        case REQUEST_NEW:
+            record = request.start;
+            reply("ok " + prefix, request.arrival);
+            return;
+        case REQUEST_FEN:
+            record.unpack(board);
+            reply("ok " + prefix + " " + board.toFEN(), request.arrival);
+            return;
+        case REQUEST_CLOSE:
+            record.flags = 0;
+            reply("ok " + prefix + " closed", request.arrival);
+            return;
+        case REQUEST_MOVE:
+            break;
+    }
+
+    record.unpack(board);
+    Move move = board.moveFromString(request.move);
+    if (move == NO_MOVE) {
+        bool over = board.status() != ONGOING;
+        reply("error " + prefix + (over ? " game over" : " illegal move " + std::string(request.move)),
+              request.arrival);
+        return;
+    }
+    UndoInfo undo;
+    board.doMove(move, undo);
+    record.pack(board);
+
+    std::string line = "ok " + prefix + " " + moveToString(move);
+    GameStatus status = board.status();
+    if (status == CHECKMATE) line += " checkmate";
+    else if (status == STALEMATE) line += " stalemate";
+    else if (board.isInCheck(board.isWhiteTurn)) line += " check";
+    reply(line, request.arrival);
+}
+
+bool GameServer::handle(const std::string& line) {
+    int64_t arrival = nowNanoseconds();
+    std::istringstream args(line);
+    std::string command;
+    args >> command;
+
+    if (command == "quit") {
+        return false;
+    }
+    if (command.empty()) {
+        return true;
+    }
+    if (command == "new") {
+        std::string fen;
+        std::getline(args >> std::ws, fen);
+        Board board;
+        if (!board.fromFEN(fen.empty() ? START_FEN : fen)) {
+            reply("error new invalid fen", arrival);
+            return true;
+        }
+        if (freeSlots.empty()) {
+            reply("error new server full", arrival);
+            return true;
+        }
+        uint32_t id = freeSlots.back();
+        freeSlots.pop_back();
+        open[id] = true;
+
+        Request request{};
+        request.kind = REQUEST_NEW;
+        request.start.flags = GameRecord::IN_USE;
+        request.start.pack(board);
+        request.arrival = arrival;
+        enqueue(id, request);
+        return true;
+    }
+    if (command == "stats") {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        send(statsLine());
+        return true;
+    }
+
+    std::string idText;
+    args >> idText;
+    char* end = nullptr;
+    unsigned long id = std::strtoul(idText.c_str(), &end, 10);
+    if (idText.empty() || *end != '\0' || id >= slab.size() || !open[id]) {
+        reply("error " + (idText.empty() ? std::string("-") : idText) + " unknown game", arrival);
+        return true;
+    }
+
+    Request request{};
+    request.arrival = arrival;
+    if (command == "move") {
+        std::string move;
+        args >> move;
+        if (move.empty() || move.size() >= sizeof(request.move)) {
+            reply("error " + idText + " illegal move " + move, arrival);
+            return true;
+        }
+        request.kind = REQUEST_MOVE;
+        std::memcpy(request.move, move.c_str(), move.size() + 1);
+    } else if (command == "fen") {
+        request.kind = REQUEST_FEN;
+    } else if (command == "close") {
+        // The slot can be handed out again at once: the next game's opening
+        // request queues up behind this one
+        request.kind = REQUEST_CLOSE;
+        open[id] = false;
+        freeSlots.push_back(static_cast<uint32_t>(id));
+    } else {
+        reply("error " + idText + " unknown command " + command, arrival);
+        return true;
+    }
+    enqueue(static_cast<uint32_t>(id), request);
+    return true;
+}
+
+// Opens `games` games and plays random legal moves in all of them, one
+// request per game per round, through the same request path as a client.
+// Like clients waiting for their replies, it keeps only a few requests per
+// thread in flight, so the latencies are not just time spent queueing.
+static int runServerBench(int games, int moves, int threads) {
+    uint64_t errors = 0;
+    std::atomic<int> inFlight(0);
+    GameServer server(threads, static_cast<uint32_t>(games), [&](const std::string& line) {
+        if (line.compare(0, 5, "error") == 0) errors++;  // Calls are serialised by the server
+        inFlight--;
+    });
+    const int window = 4 * threads;
+    auto request = [&](const std::string& line) {
+        while (inFlight.load() >= window) {
+            std::this_thread::yield();
+        }
+        inFlight++;
+        server.handle(line);
+    };
+
+    for (int i = 0; i < games; i++) {
+        request("new");
+    }
+    server.drain();
+
+    // The client keeps its own copy of each game to pick legal moves from
+    std::vector<Board> boards(games);
+    std::mt19937 random(7);
+    auto start = std::chrono::steady_clock::now();
+    uint64_t sent = 0;
+    for (int round = 0; round < moves; round++) {
+        for (int id = 0; id < games; id++) {
+            Board& board = boards[id];
+            MoveList legal;
+            board.generateLegalMoves(board.isWhiteTurn ? WHITE : BLACK, legal);
+            if (legal.empty()) {
+                board.fromFEN(START_FEN);
+                request("close " + std::to_string(id));
+                request("new");
+                sent += 2;
+                continue;
+            }
+            Move move = legal[random() % legal.size()];
+            request("move " + std::to_string(id) + " " + moveToString(move));
+            sent++;
+            UndoInfo undo;
+            board.doMove(move, undo);
+        }
+    }
+    server.drain();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << server.statsLine() << "\n";
+    std::cout << "Requests: " << sent << " in " << static_cast<long long>(seconds * 1000) << " ms ("
+              << static_cast<uint64_t>(sent / (seconds > 0 ? seconds : 1e-9)) << "/s) on " << threads
+              << " threads, errors: " << errors << "\n";
+    std::cout << "Memory: " << GameServer::bytesPerGame() << " bytes per game (a Board is " << sizeof(Board)
+              << " bytes)\n";
+    return errors ? 2 : 0;
+}
+
+int runServer(int argc, char* argv[]) {
+    int hardware = static_cast<int>(std::thread::hardware_concurrency());
+    if (argc > 0 && std::string(argv[0]) == "bench") {
+        int games = (argc > 1) ? std::atoi(argv[1]) : 10000;
+        int moves = (argc > 2) ? std::atoi(argv[2]) : 50;
+        int threads = (argc > 3) ? std::atoi(argv[3]) : hardware;
+        return runServerBench(std::max(games, 1), std::max(moves, 1), std::max(threads, 1));
+    }
+
+    int threads = (argc > 0) ? std::atoi(argv[0]) : hardware;
+    long capacity = (argc > 1) ? std::atol(argv[1]) : 65536;
+    GameServer server(std::max(threads, 1), static_cast<uint32_t>(std::max(capacity, 1L)),
+                      [](const std::string& line) { std::cout << line << "\n" << std::flush; });
+    std::string line;
+    while (std::getline(std::cin, line) && server.handle(line)) {
+    }
+    server.drain();
+    return 0;
+}
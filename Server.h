@@ -0,0 +1,114 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "Board.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A game as the server keeps it: the position packed into 40 bytes. Boards
+// are only unpacked for the moment a move is checked.
+struct GameRecord {
+    uint8_t squares[32];      // Two squares per byte, a1 in the low nibble: 0 empty,
+                              // 1 + piece type for White, 9 + piece type for Black
+    uint16_t fullmoveNumber;
+    uint8_t halfmoveClock;
+    uint8_t castlingRights;
+    int8_t enPassantSquare;   // NO_SQUARE if none
+    uint8_t flags;            // IN_USE, WHITE_TO_MOVE
+    uint8_t reserved[2];
+
+    enum { IN_USE = 1, WHITE_TO_MOVE = 2 };
+
+    void pack(const Board& board);
+    void unpack(Board& board) const;
+};
+static_assert(sizeof(GameRecord) == 40, "game records are meant to stay 40 bytes");
+
+// Hosts many games at once for clients behind a line-based proxy. Requests
+// name a game by the id "new" returned:
+//
+//   new [fen]          -> ok <id>
+//   move <id> <move>   -> ok <id> <move> [check|checkmate|stalemate]
+//   fen <id>           -> ok <id> <fen>
+//   close <id>         -> ok <id> closed
+//   stats              -> stats games <n> bytes/game <n> requests <n> p50 <us> p99 <us> max <us>
+//
+// Failures answer "error <id> <reason>". Games live in one fixed slab of
+// GameRecords with a free list of slots. Requests for a game, including the
+// one that opens it, are queued in arrival order and the game runs as one
+// task on a work-stealing pool, so different games are checked in parallel
+// and a record is only ever touched by one thread at a time. Replies to
+// different games can come back in any order.
+class GameServer {
+public:
+    // Replies go to `send`, which is called from the pool threads one at a
+    // time
+    GameServer(int threads, uint32_t capacity, std::function<void(const std::string&)> send);
+
+    // Handle one request line; false for "quit". Requests are read on one
+    // thread, which also owns the free list.
+    bool handle(const std::string& line);
+
+    // Block until every request so far is answered
+    void drain() { pool.wait(); }
+
+    size_t liveGames() const { return slab.size() - freeSlots.size(); }
+
+    // Bytes per game: its record plus its free-list slot
+    static size_t bytesPerGame() { return sizeof(GameRecord) + sizeof(uint32_t); }
+
+    // Request latency from arrival to reply, in microseconds
+    double latencyPercentile(double fraction) const;
+    uint64_t requestCount() const;
+    std::string statsLine() const;
+
+private:
+    enum RequestKind { REQUEST_NEW, REQUEST_MOVE, REQUEST_FEN, REQUEST_CLOSE };
+
+    struct Request {
+        RequestKind kind;
+        char move[8];
+        GameRecord start;     // Opening position for REQUEST_NEW
+        int64_t arrival;      // steady_clock nanoseconds
+    };
+
+    // Only pool tasks touch the records; only the reading thread touches
+    // the free list and `open`
+    std::vector<GameRecord> slab;
+    std::vector<uint32_t> freeSlots;
+    std::vector<bool> open;
+
+    // Games with requests waiting, and whether a pool task is running them.
+    // A game is in the map exactly while a task for it is queued or running.
+    std::unordered_map<uint32_t, std::deque<Request>> queuedRequests;
+    std::mutex queueMutex;
+
+    // Latency histogram with 1-microsecond buckets; the last one collects
+    // everything slower
+    static const int LATENCY_BUCKETS = 10001;
+    std::vector<std::atomic<uint64_t>> latency;
+
+    std::function<void(const std::string&)> send;
+    std::mutex sendMutex;
+    ThreadPool pool;  // Last, so it is joined before the rest goes away
+
+    void reply(const std::string& line, int64_t arrival);
+    void enqueue(uint32_t id, const Request& request);
+    void runGame(uint32_t id);
+    void execute(uint32_t id, const Request& request);
+};
+
+// Command line entry:
+//   server [threads] [max games]         line protocol on stdin/stdout
+//   server bench [games] [moves] [threads]  load test through the same path
+int runServer(int argc, char* argv[]);
+
+#endif // SERVER_H
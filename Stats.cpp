@@ -0,0 +1,150 @@
+#include "Stats.h"
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+// Only the owning thread writes its block, so plain loads and stores are
+// enough; the atomics just make the reads from collectStats well defined.
+struct ThreadStats {
+    std::atomic<uint64_t> calls[STAT_KINDS];
+    std::atomic<uint64_t> ticks[STAT_KINDS];
+};
+
+static std::mutex registryMutex;
+static std::vector<ThreadStats*>& liveThreads() {
+    static std::vector<ThreadStats*> threads;
+    return threads;
+}
+static uint64_t retiredCalls[STAT_KINDS];
+static uint64_t retiredTicks[STAT_KINDS];
+
+// Zero-initialised without a constructor, so using it costs no guard check
+static thread_local ThreadStats threadStats;
+static thread_local bool threadRegistered = false;
+
+// Adds the thread's block to the registry, and folds it into the retired
+// totals when the thread exits
+struct ThreadRegistration {
+    ThreadRegistration() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        liveThreads().push_back(&threadStats);
+    }
+    ~ThreadRegistration() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (int k = 0; k < STAT_KINDS; k++) {
+            retiredCalls[k] += threadStats.calls[k].load(std::memory_order_relaxed);
+            retiredTicks[k] += threadStats.ticks[k].load(std::memory_order_relaxed);
+        }
+        auto& threads = liveThreads();
+        for (size_t i = 0; i < threads.size(); i++) {
+            if (threads[i] == &threadStats) {
+                threads.erase(threads.begin() + i);
+                break;
+            }
+        }
+    }
+};
+
+void recordStat(StatKind kind, uint64_t ticks) {
+    if (!threadRegistered) {
+        static thread_local ThreadRegistration registration;
+        threadRegistered = true;
+    }
+    ThreadStats& s = threadStats;
+    s.calls[kind].store(s.calls[kind].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    s.ticks[kind].store(s.ticks[kind].load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+}
+
+const char* statName(StatKind kind) {
+    static const char* const NAMES[STAT_KINDS] = {
+        "isValidMove", "isInCheck", "getValidMoves", "isCheckmate"
+    };
+    return NAMES[kind];
+}
+
+// statClock ticks per nanosecond, measured once against the steady clock
+static double ticksPerNanosecond() {
+#ifdef STATS_TSC
+    static const double rate = []() {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t startTicks = statClock();
+        while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(10)) {}
+        uint64_t ticks = statClock() - startTicks;
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        return ns > 0 ? ticks / ns : 1.0;
+    }();
+    return rate;
+#else
+    return 1.0;
+#endif
+}
+
+StatsSnapshot collectStats() {
+    StatsSnapshot snapshot;
+    uint64_t ticks[STAT_KINDS] = {};
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (int k = 0; k < STAT_KINDS; k++) {
+            snapshot.calls[k] = retiredCalls[k];
+            ticks[k] = retiredTicks[k];
+        }
+        for (ThreadStats* s : liveThreads()) {
+            for (int k = 0; k < STAT_KINDS; k++) {
+                snapshot.calls[k] += s->calls[k].load(std::memory_order_relaxed);
+                ticks[k] += s->ticks[k].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    double rate = ticksPerNanosecond();
+    for (int k = 0; k < STAT_KINDS; k++) {
+        snapshot.nanoseconds[k] = static_cast<uint64_t>(ticks[k] / rate);
+    }
+    return snapshot;
+}
+
+void resetStats() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (int k = 0; k < STAT_KINDS; k++) {
+        retiredCalls[k] = retiredTicks[k] = 0;
+    }
+    for (ThreadStats* s : liveThreads()) {
+        for (int k = 0; k < STAT_KINDS; k++) {
+            s->calls[k].store(0, std::memory_order_relaxed);
+            s->ticks[k].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void printStats(std::ostream& out) {
+    if (!STATS_ENABLED) {
+        out << "Statistics are not compiled in; rebuild with -DCHESS_STATS\n";
+        return;
+    }
+    StatsSnapshot stats = collectStats();
+    out << std::left << std::setw(16) << "function" << std::right << std::setw(14) << "calls"
+        << std::setw(12) << "total ms" << std::setw(10) << "ns/call" << "\n";
+    for (int k = 0; k < STAT_KINDS; k++) {
+        uint64_t calls = stats.calls[k];
+        out << std::left << std::setw(16) << statName(static_cast<StatKind>(k)) << std::right
+            << std::setw(14) << calls << std::setw(12) << std::fixed << std::setprecision(1)
+            << stats.nanoseconds[k] / 1e6 << std::setw(10) << (calls ? stats.nanoseconds[k] / calls : 0) << "\n";
+    }
+    out << "(times include nested counted calls)\n";
+}
+
+void printStatsJson(std::ostream& out) {
+    out << "{\"stats\":";
+    if (!STATS_ENABLED) {
+        out << "null}\n";
+        return;
+    }
+    StatsSnapshot stats = collectStats();
+    out << "{";
+    for (int k = 0; k < STAT_KINDS; k++) {
+        out << (k ? "," : "") << "\"" << statName(static_cast<StatKind>(k)) << "\":{\"calls\":" << stats.calls[k]
+            << ",\"ns\":" << stats.nanoseconds[k] << "}";
+    }
+    out << "}}\n";
+}
@@ -0,0 +1,88 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <cstdint>
+#include <ostream>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define STATS_TSC
+#else
+#include <chrono>
+#endif
+
+// Call counters for the Board rule checks, compiled in with -DCHESS_STATS.
+// Without it the STAT_ macros expand to nothing and the hot paths are the
+// same code as before.
+//
+// Each thread counts into its own block; collectStats() adds the blocks up
+// (plus those of threads that have exited) when the numbers are read, so
+// counting never contends between threads.
+enum StatKind {
+    STAT_IS_VALID_MOVE,
+    STAT_IS_IN_CHECK,
+    STAT_GET_VALID_MOVES,
+    STAT_IS_CHECKMATE,
+    STAT_KINDS
+};
+
+struct StatsSnapshot {
+    uint64_t calls[STAT_KINDS] = {};
+    uint64_t nanoseconds[STAT_KINDS] = {};  // Inclusive of nested counted calls
+};
+
+#ifdef CHESS_STATS
+const bool STATS_ENABLED = true;
+#else
+const bool STATS_ENABLED = false;
+#endif
+
+// Cheap timestamp: the time stamp counter on x86, nanoseconds elsewhere
+inline uint64_t statClock() {
+#ifdef STATS_TSC
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Add one call, and its duration in statClock ticks, to this thread's block
+void recordStat(StatKind kind, uint64_t ticks);
+
+// Times the enclosing scope
+class StatTimer {
+public:
+    explicit StatTimer(StatKind kind) : kind(kind), start(statClock()) {}
+    ~StatTimer() { recordStat(kind, statClock() - start); }
+
+    StatTimer(const StatTimer&) = delete;
+    StatTimer& operator=(const StatTimer&) = delete;
+
+private:
+    StatKind kind;
+    uint64_t start;
+};
+
+#ifdef CHESS_STATS
+#define STAT_SCOPE(kind) StatTimer statTimer(kind)
+#else
+#define STAT_SCOPE(kind) ((void)0)
+#endif
+
+const char* statName(StatKind kind);
+
+// Totals over every thread so far
+StatsSnapshot collectStats();
+void resetStats();
+
+// A table for the interactive `stats` command, and one JSON object for
+// scripts; both note when the counters are not compiled in
+void printStats(std::ostream& out);
+void printStatsJson(std::ostream& out);
+
+#endif // STATS_H
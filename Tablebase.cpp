@@ -0,0 +1,907 @@
+#include "Tablebase.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+Tablebases tablebases;
+
+// Order pieces appear in within one side of a table name
+static const char NAME_ORDER[] = "QRBNP";
+static const int NAME_VALUES[] = {9, 5, 3, 3, 1};
+
+static PieceType typeOfLetter(char c) {
+    switch (c) {
+        case 'Q': return QUEEN;
+        case 'R': return ROOK;
+        case 'B': return BISHOP;
+        case 'N': return KNIGHT;
+        case 'P': return PAWN;
+        default: return NO_PIECE_TYPE;
+    }
+}
+
+static int sideValue(const std::string& side) {
+    int value = 0;
+    for (char c : side) {
+        const char* p = std::strchr(NAME_ORDER, c);
+        if (c != 'K' && p) value += NAME_VALUES[p - NAME_ORDER];
+    }
+    return value;
+}
+
+// Whether the side written as `a` ("KQ") goes first in a table name against `b`
+static bool isStrongerSide(const std::string& a, const std::string& b) {
+    int va = sideValue(a);
+    int vb = sideValue(b);
+    return va != vb ? va > vb : a >= b;
+}
+
+// Material signatures: every piece besides the kings is a kind from 1 to 10
+// (white QRBNP, then black QRBNP), and the kinds in ascending order are the
+// digits of a base-11 number. Up to two such pieces it stays below 121.
+static_assert(TB_MAX_PIECES <= 4, "material signatures cover two pieces besides the kings");
+
+static int pieceKind(Color color, PieceType type) {
+    return 1 + color * 5 + (QUEEN - type);
+}
+
+static int materialSignature(const Board& board) {
+    int signature = 0;
+    for (Color c : { WHITE, BLACK }) {
+        for (const char* p = NAME_ORDER; *p; p++) {
+            for (int n = popCount(board.piecesOf(c, typeOfLetter(*p))); n > 0; n--) {
+                signature = signature * 11 + pieceKind(c, typeOfLetter(*p));
+            }
+        }
+    }
+    return signature;
+}
+
+// Signature of a table's pieces with its stronger half played by `strong`
+static int materialSignature(const TablebaseMaterial& material, Color strong) {
+    int kinds[TB_MAX_PIECES];
+    int count = 0;
+    for (int i = 2; i < material.count; i++) {
+        kinds[count++] = pieceKind(material.colors[i] == WHITE ? strong : !strong, material.types[i]);
+    }
+    std::sort(kinds, kinds + count);
+    int signature = 0;
+    for (int i = 0; i < count; i++) signature = signature * 11 + kinds[i];
+    return signature;
+}
+
+// Kings only, or a lone minor piece: no table needed
+static bool isDeadDraw(int signature) {
+    return signature == 0 || signature == pieceKind(WHITE, BISHOP) || signature == pieceKind(WHITE, KNIGHT) ||
+           signature == pieceKind(BLACK, BISHOP) || signature == pieceKind(BLACK, KNIGHT);
+}
+
+static bool isDeadDraw(const std::string& name) {
+    std::string rest;
+    for (char c : name) {
+        if (c != 'K' && c != 'v') rest += c;
+    }
+    return rest.empty() || rest == "B" || rest == "N";
+}
+
+bool TablebaseMaterial::parse(const std::string& text) {
+    size_t split = text.find('v');
+    if (split == std::string::npos) return false;
+    std::string sides[2] = { text.substr(0, split), text.substr(split + 1) };
+    int total = 0;
+    for (std::string& side : sides) {
+        if (side.empty() || side[0] != 'K') return false;
+        std::string rest = side.substr(1);
+        for (char c : rest) {
+            if (typeOfLetter(c) == NO_PIECE_TYPE) return false;
+        }
+        std::sort(rest.begin(), rest.end(), [](char a, char b) {
+            return std::strchr(NAME_ORDER, a) < std::strchr(NAME_ORDER, b);
+        });
+        side = "K" + rest;
+        total += static_cast<int>(side.size());
+    }
+    if (!isStrongerSide(sides[0], sides[1])) std::swap(sides[0], sides[1]);
+    if (total > TB_MAX_PIECES) return false;
+    if (sides[0].find('P') != std::string::npos && sides[1].find('P') != std::string::npos) return false;
+
+    name = sides[0] + "v" + sides[1];
+    if (isDeadDraw(name)) return false;
+    hasPawns = name.find('P') != std::string::npos;
+    count = 0;
+    colors[count] = WHITE;
+    types[count++] = KING;
+    colors[count] = BLACK;
+    types[count++] = KING;
+    for (int c = 0; c < 2; c++) {
+        for (size_t i = 1; i < sides[c].size(); i++) {
+            colors[count] = static_cast<Color>(c);
+            types[count++] = typeOfLetter(sides[c][i]);
+        }
+    }
+    return true;
+}
+
+// Squares the white king is kept on: the a1-d1-d4 triangle without pawns,
+// files a-d with them
+static const int TRIANGLE_SQUARES[10] = { 0, 1, 2, 3, 9, 10, 11, 18, 19, 27 };
+
+struct KingDomain {
+    int triangle[64];
+    int half[64];
+};
+
+constexpr KingDomain makeKingDomain() {
+    KingDomain domain{};
+    for (int sq = 0; sq < 64; sq++) {
+        domain.triangle[sq] = -1;
+        domain.half[sq] = colOf(sq) < 4 ? rowOf(sq) * 4 + colOf(sq) : -1;
+    }
+    int next = 0;
+    for (int row = 0; row < 4; row++) {
+        for (int col = row; col < 4; col++) {
+            domain.triangle[makeSquare(row, col)] = next++;
+        }
+    }
+    return domain;
+}
+
+static constexpr KingDomain KING_DOMAIN = makeKingDomain();
+
+static int kingSquares(const TablebaseMaterial& material) {
+    return material.hasPawns ? 32 : 10;
+}
+
+uint64_t TablebaseMaterial::size() const {
+    uint64_t entries = 2 * static_cast<uint64_t>(kingSquares(*this));
+    for (int i = 1; i < count; i++) entries *= 64;
+    return entries;
+}
+
+uint64_t tablebaseIndex(const TablebaseMaterial& material, const int* squares, Color sideToMove) {
+    // Pick the mirror images that bring the white king into its domain
+    int wk = squares[0];
+    int flip = (colOf(wk) > 3) ? 7 : 0;
+    bool transpose = false;
+    if (!material.hasPawns) {
+        if (rowOf(wk) > 3) flip |= 56;
+        wk ^= flip;
+        transpose = rowOf(wk) > colOf(wk);
+        // A king on the diagonal leaves the choice to the next piece off it
+        for (int i = 1; i < material.count && rowOf(wk) == colOf(wk); i++) {
+            int sq = squares[i] ^ flip;
+            if (rowOf(sq) != colOf(sq)) {
+                transpose = rowOf(sq) > colOf(sq);
+                break;
+            }
+        }
+    }
+    auto map = [&](int sq) {
+        sq ^= flip;
+        return transpose ? makeSquare(colOf(sq), rowOf(sq)) : sq;
+    };
+
+    int king = map(squares[0]);
+    uint64_t index = static_cast<uint64_t>(sideToMove) * kingSquares(material) +
+                     (material.hasPawns ? KING_DOMAIN.half[king] : KING_DOMAIN.triangle[king]);
+    for (int i = 1; i < material.count; i++) {
+        index = index * 64 + map(squares[i]);
+    }
+    return index;
+}
+
+// Inverse of tablebaseIndex for positions already in their canonical image.
+// False for entries that are not positions (shared squares, pawns on the
+// first or last rank) or are the mirror image of another entry.
+static bool decodeIndex(const TablebaseMaterial& material, uint64_t index, int* squares, Color& sideToMove) {
+    for (int i = material.count - 1; i >= 1; i--) {
+        squares[i] = static_cast<int>(index % 64);
+        index /= 64;
+    }
+    int domain = kingSquares(material);
+    int king = static_cast<int>(index % domain);
+    sideToMove = static_cast<Color>(index / domain);
+    squares[0] = material.hasPawns ? makeSquare(king / 4, king % 4) : TRIANGLE_SQUARES[king];
+
+    Bitboard seen = 0;
+    for (int i = 0; i < material.count; i++) {
+        if (seen & squareBB(squares[i])) return false;
+        seen |= squareBB(squares[i]);
+        if (material.types[i] == PAWN && (rowOf(squares[i]) == 0 || rowOf(squares[i]) == 7)) return false;
+    }
+    for (int i = 0; i < material.count && !material.hasPawns; i++) {
+        if (rowOf(squares[i]) != colOf(squares[i])) return rowOf(squares[i]) < colOf(squares[i]);
+    }
+    return true;
+}
+
+// The board's squares and side to move in the order of a table whose
+// stronger half `strong` holds. With the colors swapped the board is
+// mirrored top to bottom as well, so pawns keep moving up the board.
+static void tableSquares(const Board& board, Color strong, int* squares, Color& sideToMove) {
+    int mirror = (strong == WHITE) ? 0 : 56;
+    int count = 0;
+    squares[count++] = board.getKingSquare(strong) ^ mirror;
+    squares[count++] = board.getKingSquare(!strong) ^ mirror;
+    for (Color c : { strong, !strong }) {
+        for (const char* p = NAME_ORDER; *p; p++) {
+            Bitboard b = board.piecesOf(c, typeOfLetter(*p));
+            while (b) squares[count++] = popLsb(b) ^ mirror;
+        }
+    }
+    Color us = board.isWhiteTurn ? WHITE : BLACK;
+    sideToMove = (strong == WHITE) ? us : !us;
+}
+
+bool tablebaseKey(const Board& board, std::string& name, int* squares, Color& sideToMove) {
+    if (popCount(board.occupancy()) > TB_MAX_PIECES) return false;
+
+    std::string sides[2];
+    for (int c = 0; c < 2; c++) {
+        sides[c] = "K";
+        for (const char* p = NAME_ORDER; *p; p++) {
+            sides[c].append(popCount(board.piecesOf(static_cast<Color>(c), typeOfLetter(*p))), *p);
+        }
+    }
+    Color strong = isStrongerSide(sides[WHITE], sides[BLACK]) ? WHITE : BLACK;
+    name = sides[strong] + "v" + sides[!strong];
+    tableSquares(board, strong, squares, sideToMove);
+    return true;
+}
+
+// Packed entries start after a 64-byte header
+struct TablebaseHeader {
+    char magic[8];
+    char name[16];
+    uint32_t bits;
+    uint32_t longestMate;
+    uint64_t entries;
+    char reserved[24];
+};
+static_assert(sizeof(TablebaseHeader) == 64, "tablebase header must be 64 bytes");
+
+static const char TB_MAGIC[8] = { 'C', 'H', 'S', 'T', 'B', '0', '0', '1' };
+
+// Entries are `bits` wide and may straddle a byte boundary, never two
+static int readPacked(const uint8_t* data, uint64_t index, int bits) {
+    uint64_t bit = index * bits;
+    unsigned word = data[bit / 8] | (static_cast<unsigned>(data[bit / 8 + 1]) << 8);
+    return (word >> (bit % 8)) & ((1u << bits) - 1);
+}
+
+int Tablebases::load(const std::string& directory) {
+    clear();
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.path().extension() != ".tb") continue;
+
+        auto table = std::make_unique<Table>();
+        if (!table->file.open(entry.path().string()) || table->file.size() < sizeof(TablebaseHeader)) {
+            continue;
+        }
+        TablebaseHeader header;
+        std::memcpy(&header, table->file.data(), sizeof(header));
+        header.name[sizeof(header.name) - 1] = '\0';
+        if (std::memcmp(header.magic, TB_MAGIC, sizeof(TB_MAGIC)) != 0 ||
+            !table->material.parse(header.name) || header.entries != table->material.size() ||
+            header.bits < 1 || header.bits > 8 ||
+            table->file.size() < sizeof(header) + (header.entries * header.bits + 7) / 8 + 1) {
+            continue;
+        }
+        table->bits = static_cast<int>(header.bits);
+        table->entries = header.entries;
+        largest = std::max(largest, table->material.count);
+        tables[table->material.name] = std::move(table);
+    }
+
+    // Both color assignments of every table; a table with the same pieces
+    // on each side keeps White as the stronger half
+    for (const auto& entry : tables) {
+        for (Color strong : { BLACK, WHITE }) {
+            bySignature[materialSignature(entry.second->material, strong)] = Slot{ entry.second.get(), strong };
+        }
+    }
+    return static_cast<int>(tables.size());
+}
+
+void Tablebases::clear() {
+    tables.clear();
+    std::fill(std::begin(bySignature), std::end(bySignature), Slot());
+    largest = 0;
+}
+
+bool Tablebases::probe(const Board& board, int& wdl, int& plies) const {
+    if (tables.empty() || board.getCastlingRights() != 0) return false;
+    if (popCount(board.occupancy()) > largest) return false;
+
+    int signature = materialSignature(board);
+    if (isDeadDraw(signature)) {
+        wdl = plies = 0;
+        return true;
+    }
+    const Slot& slot = bySignature[signature];
+    if (!slot.table) return false;
+
+    int squares[TB_MAX_PIECES];
+    Color sideToMove;
+    tableSquares(board, slot.strong, squares, sideToMove);
+    const Table& table = *slot.table;
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(table.file.data()) + sizeof(TablebaseHeader);
+    int value = readPacked(data, tablebaseIndex(table.material, squares, sideToMove), table.bits);
+    plies = (value == 0) ? 0 : value - 1;
+    wdl = (value == 0) ? 0 : (plies % 2 ? 1 : -1);
+    return true;
+}
+
+Move Tablebases::bestMove(const Board& board) const {
+    int wdl, plies;
+    if (!probe(board, wdl, plies)) return NO_MOVE;
+
+    Color us = board.isWhiteTurn ? WHITE : BLACK;
+    MoveList moves;
+    board.generateLegalMoves(us, moves);
+    Board child = board;
+    Move best = NO_MOVE;
+    int bestRank = 0;
+    for (Move move : moves) {
+        UndoInfo undo;
+        child.doMove(move, undo);
+        bool known = probe(child, wdl, plies);
+        child.undoMove(undo);
+        if (!known) continue;
+
+        // Prefer mating fast, then drawing, then losing slowly
+        int rank = -wdl * 1000 + (wdl < 0 ? -plies : plies);
+        if (best == NO_MOVE || rank > bestRank) {
+            best = move;
+            bestRank = rank;
+        }
+    }
+    return best;
+}
+
+// Run body(begin, end) over [0, count) in chunks, on `threads` threads
+template <typename Body>
+static void parallelFor(uint64_t count, int threads, Body body) {
+    const uint64_t CHUNK = 1 << 14;
+    std::atomic<uint64_t> next(0);
+    auto worker = [&]() {
+        for (;;) {
+            uint64_t begin = next.fetch_add(CHUNK);
+            if (begin >= count) break;
+            body(begin, std::min(begin + CHUNK, count));
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; i++) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+}
+
+// Whether `target` is attacked by the `by` pieces of a table position
+static bool isAttackedIn(const TablebaseMaterial& material, const int* squares, int target, Color by) {
+    Bitboard occupied = 0;
+    for (int i = 0; i < material.count; i++) occupied |= squareBB(squares[i]);
+    for (int i = 0; i < material.count; i++) {
+        if (material.colors[i] != by) continue;
+        int sq = squares[i];
+        Bitboard attacks = 0;
+        switch (material.types[i]) {
+            case PAWN: attacks = pawnAttacks(by, sq); break;
+            case KNIGHT: attacks = knightAttacks(sq); break;
+            case BISHOP: attacks = bishopAttacks(sq, occupied); break;
+            case ROOK: attacks = rookAttacks(sq, occupied); break;
+            case QUEEN: attacks = queenAttacks(sq, occupied); break;
+            default: attacks = kingAttacks(sq); break;
+        }
+        if (attacks & squareBB(target)) return true;
+    }
+    return false;
+}
+
+// Generates a table by retrograde analysis. Every legal position first gets
+// its moves generated once with Board: mates and stalemates are final, and
+// captures and promotions are scored from the smaller tables generated
+// before. Then distances grow one ply at a time. Each position lost in n
+// plies makes its predecessors (found by un-moving the side that just moved)
+// won in n + 1; each position won in n + 1 counts down a move of its
+// predecessors, and a predecessor whose moves all lose is checked with Board
+// once more and becomes lost. Whatever is never reached is a draw.
+class TablebaseGenerator {
+public:
+    explicit TablebaseGenerator(int threads) : threads(threads) {}
+
+    // Generates the table and the smaller ones it converts into, writing each
+    // as <directory>/<name>.tb
+    bool generate(const std::string& name, const std::string& directory);
+
+private:
+    // Working values while generating
+    enum : uint8_t { UNKNOWN, DRAW, ILLEGAL, RESULT };
+
+    struct Generated {
+        TablebaseMaterial material;
+        std::vector<uint8_t> values;  // File encoding: 0 draw, else distance + 1
+    };
+
+    int threads;
+    std::map<std::string, Generated> done;
+
+    TablebaseMaterial material;
+    std::unique_ptr<std::atomic<uint8_t>[]> state;    // UNKNOWN, DRAW, ILLEGAL or RESULT + distance
+    std::unique_ptr<std::atomic<int16_t>[]> pending;  // Moves not yet known to lose
+    std::unique_ptr<std::atomic<uint8_t>[]> lossAt;   // Distance a checked loss takes effect, 0 if none
+    std::unique_ptr<uint8_t[]> captureWin;            // Fastest win by capture or promotion, 0 if none
+
+    std::vector<std::string> dependencies(const TablebaseMaterial& m) const;
+    int finishedValue(const Board& board) const;
+    void setup(Board& board, const int* squares, Color sideToMove) const;
+    void initialize(uint64_t index, Board& board);
+    template <typename Visit>
+    void forEachPredecessor(const int* squares, Color sideToMove, Visit visit) const;
+    void checkLoss(uint64_t index, Board& board);
+    bool write(const std::string& directory, const Generated& table, int longestMate) const;
+};
+
+std::vector<std::string> TablebaseGenerator::dependencies(const TablebaseMaterial& m) const {
+    std::vector<std::string> names;
+    std::string sides[2] = { m.name.substr(0, m.name.find('v')), m.name.substr(m.name.find('v') + 1) };
+    for (int c = 0; c < 2; c++) {
+        for (size_t i = 1; i < sides[c].size(); i++) {
+            // The piece is captured, or a pawn promotes
+            std::string changed[2] = { sides[0], sides[1] };
+            changed[c].erase(i, 1);
+            TablebaseMaterial sub;
+            if (sub.parse(changed[0] + "v" + changed[1])) names.push_back(sub.name);
+            if (sides[c][i] == 'P') {
+                for (char promotion : std::string("QRBN")) {
+                    changed[c] = sides[c];
+                    changed[c][i] = promotion;
+                    if (sub.parse(changed[0] + "v" + changed[1])) names.push_back(sub.name);
+                }
+            }
+        }
+    }
+    return names;
+}
+
+// File-encoded value of a position in an already generated table
+int TablebaseGenerator::finishedValue(const Board& board) const {
+    std::string name;
+    int squares[TB_MAX_PIECES];
+    Color sideToMove;
+    tablebaseKey(board, name, squares, sideToMove);
+    auto it = done.find(name);
+    if (it == done.end()) return 0;  // Dead draw
+    return it->second.values[tablebaseIndex(it->second.material, squares, sideToMove)];
+}
+
+void TablebaseGenerator::setup(Board& board, const int* squares, Color sideToMove) const {
+    PiecePlacement placements[TB_MAX_PIECES];
+    for (int i = 0; i < material.count; i++) {
+        placements[i] = PiecePlacement{ material.colors[i], material.types[i], squares[i] };
+    }
+    board.setPosition(placements, material.count, sideToMove == WHITE);
+}
+
+static bool isConversion(const Board& board, Move move) {
+    return board.isCapture(move) || moveKind(move) == PROMOTION;
+}
+
+void TablebaseGenerator::initialize(uint64_t index, Board& board) {
+    int squares[TB_MAX_PIECES];
+    Color us;
+    pending[index] = 0;
+    lossAt[index] = 0;
+    captureWin[index] = 0;
+    if (!decodeIndex(material, index, squares, us)) {
+        state[index] = ILLEGAL;
+        return;
+    }
+    setup(board, squares, us);
+    if (board.isInCheck(us == BLACK)) {  // The side that just moved left its king attacked
+        state[index] = ILLEGAL;
+        return;
+    }
+
+    MoveList moves;
+    board.generateLegalMoves(us, moves);
+    if (moves.empty()) {
+        state[index] = board.isInCheck(us == WHITE) ? RESULT : DRAW;
+        return;
+    }
+
+    int quiet = 0;
+    int fastestWin = 0;
+    int slowestLoss = -1;
+    bool drawn = false;
+    for (Move move : moves) {
+        if (!isConversion(board, move)) {
+            quiet++;
+            continue;
+        }
+        UndoInfo undo;
+        board.doMove(move, undo);
+        int value = finishedValue(board);
+        board.undoMove(undo);
+        int distance = value - 1;
+        if (value == 0) {
+            drawn = true;
+        } else if (distance % 2 == 0) {
+            if (fastestWin == 0 || distance + 1 < fastestWin) fastestWin = distance + 1;
+        } else {
+            slowestLoss = std::max(slowestLoss, distance);
+        }
+    }
+    // A position on the long diagonal is its own mirror image, and two of its
+    // moves can lead to mirror images of one entry that is counted down only
+    // once. Such positions are checked on every count instead.
+    bool onDiagonal = !material.hasPawns;
+    for (int i = 0; i < material.count; i++) {
+        onDiagonal = onDiagonal && rowOf(squares[i]) == colOf(squares[i]);
+    }
+    state[index] = UNKNOWN;
+    pending[index] = static_cast<int16_t>(onDiagonal ? std::min(quiet, 1) : quiet);
+    captureWin[index] = static_cast<uint8_t>(fastestWin);
+    if (quiet == 0 && fastestWin == 0) {
+        // Every move converts, and none wins
+        if (drawn) state[index] = DRAW;
+        else lossAt[index] = static_cast<uint8_t>(slowestLoss + 1);
+    }
+}
+
+// Calls visit(index) for each position, with the other side to move, that
+// reaches this one by a move that neither captures nor promotes
+template <typename Visit>
+void TablebaseGenerator::forEachPredecessor(const int* squares, Color sideToMove, Visit visit) const {
+    Color mover = !sideToMove;
+    int before[TB_MAX_PIECES];
+    std::copy(squares, squares + material.count, before);
+    Bitboard occupied = 0;
+    for (int i = 0; i < material.count; i++) occupied |= squareBB(squares[i]);
+
+    for (int i = 0; i < material.count; i++) {
+        if (material.colors[i] != mover) continue;
+        int to = squares[i];
+        Bitboard origins = 0;
+        switch (material.types[i]) {
+            case PAWN: {
+                int back = (mover == WHITE) ? -8 : 8;
+                int single = to + back;
+                if (rowOf(single) != 0 && rowOf(single) != 7 && !(occupied & squareBB(single))) {
+                    origins |= squareBB(single);
+                    int startRow = (mover == WHITE) ? 1 : 6;
+                    int twice = single + back;
+                    if (rowOf(twice) == startRow && !(occupied & squareBB(twice))) origins |= squareBB(twice);
+                }
+                break;
+            }
+            case KNIGHT: origins = knightAttacks(to); break;
+            case BISHOP: origins = bishopAttacks(to, occupied); break;
+            case ROOK: origins = rookAttacks(to, occupied); break;
+            case QUEEN: origins = queenAttacks(to, occupied); break;
+            default: origins = kingAttacks(to); break;
+        }
+        origins &= ~occupied;
+
+        while (origins) {
+            before[i] = popLsb(origins);
+            // Before the move the side now to move cannot have been in check
+            if (!isAttackedIn(material, before, before[sideToMove == WHITE ? 0 : 1], mover)) {
+                visit(tablebaseIndex(material, before, mover));
+            }
+        }
+        before[i] = to;
+    }
+}
+
+// Called when all quiet moves of an unresolved position may lose. Two moves
+// can lead to mirror images of one entry, and un-moving from that entry
+// finds the position once per image, so the count is only a hint and the
+// moves are checked again here.
+void TablebaseGenerator::checkLoss(uint64_t index, Board& board) {
+    int squares[TB_MAX_PIECES];
+    Color us;
+    decodeIndex(material, index, squares, us);
+    setup(board, squares, us);
+
+    MoveList moves;
+    board.generateLegalMoves(us, moves);
+    int slowest = 0;
+    for (Move move : moves) {
+        int distance;
+        if (isConversion(board, move)) {
+            UndoInfo undo;
+            board.doMove(move, undo);
+            int value = finishedValue(board);
+            board.undoMove(undo);
+            if (value == 0) return;
+            distance = value - 1;
+        } else {
+            int after[TB_MAX_PIECES];
+            std::copy(squares, squares + material.count, after);
+            for (int i = 0; i < material.count; i++) {
+                if (after[i] == moveFrom(move)) after[i] = moveTo(move);
+            }
+            int value = state[tablebaseIndex(material, after, !us)];
+            if (value < RESULT) return;
+            distance = value - RESULT;
+        }
+        if (distance % 2 == 0) return;  // This move wins
+        slowest = std::max(slowest, distance);
+    }
+    lossAt[index] = static_cast<uint8_t>(slowest + 1);
+}
+
+bool TablebaseGenerator::write(const std::string& directory, const Generated& table, int longestMate) const {
+    int maxValue = 1;
+    for (uint8_t v : table.values) maxValue = std::max(maxValue, static_cast<int>(v));
+    int bits = 1;
+    while ((1 << bits) <= maxValue) bits++;
+
+    uint64_t entries = table.values.size();
+    std::vector<uint8_t> packed((entries * bits + 7) / 8 + 1, 0);
+    for (uint64_t i = 0; i < entries; i++) {
+        uint64_t bit = i * bits;
+        unsigned word = static_cast<unsigned>(table.values[i]) << (bit % 8);
+        packed[bit / 8] |= static_cast<uint8_t>(word);
+        packed[bit / 8 + 1] |= static_cast<uint8_t>(word >> 8);
+    }
+
+    TablebaseHeader header{};
+    std::memcpy(header.magic, TB_MAGIC, sizeof(TB_MAGIC));
+    std::strncpy(header.name, table.material.name.c_str(), sizeof(header.name) - 1);
+    header.bits = static_cast<uint32_t>(bits);
+    header.longestMate = static_cast<uint32_t>(longestMate);
+    header.entries = entries;
+
+    std::ofstream out(directory + "/" + table.material.name + ".tb", std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(packed.data()), static_cast<std::streamsize>(packed.size()));
+    return static_cast<bool>(out);
+}
+
+bool TablebaseGenerator::generate(const std::string& name, const std::string& directory) {
+    TablebaseMaterial m;
+    if (!m.parse(name)) {
+        std::cerr << "Unsupported table " << name << "\n";
+        return false;
+    }
+    if (done.count(m.name)) return true;
+    for (const std::string& sub : dependencies(m)) {
+        if (!generate(sub, directory)) return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    material = m;
+    uint64_t size = material.size();
+    state.reset(new std::atomic<uint8_t>[size]);
+    pending.reset(new std::atomic<int16_t>[size]);
+    lossAt.reset(new std::atomic<uint8_t>[size]);
+    captureWin.reset(new uint8_t[size]);
+
+    parallelFor(size, threads, [&](uint64_t begin, uint64_t end) {
+        Board board;
+        for (uint64_t i = begin; i < end; i++) initialize(i, board);
+    });
+    int horizon = 0;
+    for (uint64_t i = 0; i < size; i++) {
+        horizon = std::max({ horizon, static_cast<int>(captureWin[i]), static_cast<int>(lossAt[i]) });
+    }
+
+    // Distance by distance until nothing changes and no capture result is
+    // still to come
+    for (int ply = 0; ply <= 250 && ply <= horizon; ply++) {
+        std::atomic<int> furthest(horizon);
+        auto extend = [&](int distance) {
+            int seen = furthest.load();
+            while (distance > seen && !furthest.compare_exchange_weak(seen, distance)) {}
+        };
+        const uint8_t current = static_cast<uint8_t>(RESULT + ply);
+        const uint8_t next = static_cast<uint8_t>(RESULT + ply + 1);
+
+        if (ply % 2 == 0) {
+            // Losses in ply take effect; their predecessors and fast enough
+            // captures win in ply + 1
+            parallelFor(size, threads, [&](uint64_t begin, uint64_t end) {
+                for (uint64_t i = begin; i < end; i++) {
+                    if (ply > 0 && state[i] == UNKNOWN && lossAt[i] == ply) state[i] = current;
+                }
+            });
+            parallelFor(size, threads, [&](uint64_t begin, uint64_t end) {
+                int squares[TB_MAX_PIECES];
+                Color us;
+                for (uint64_t i = begin; i < end; i++) {
+                    if (state[i] != current) continue;
+                    decodeIndex(material, i, squares, us);
+                    forEachPredecessor(squares, us, [&](uint64_t before) {
+                        uint8_t expected = UNKNOWN;
+                        if (state[before].compare_exchange_strong(expected, next)) extend(ply + 2);
+                    });
+                }
+            });
+            parallelFor(size, threads, [&](uint64_t begin, uint64_t end) {
+                for (uint64_t i = begin; i < end; i++) {
+                    if (state[i] == UNKNOWN && captureWin[i] == ply + 1) state[i] = next;
+                }
+            });
+        } else {
+            // Wins in ply count down their predecessors' moves
+            parallelFor(size, threads, [&](uint64_t begin, uint64_t end) {
+                Board board;
+                int squares[TB_MAX_PIECES];
+                Color us;
+                for (uint64_t i = begin; i < end; i++) {
+                    if (state[i] != current) continue;
+                    decodeIndex(material, i, squares, us);
+                    forEachPredecessor(squares, us, [&](uint64_t before) {
+                        if (state[before] != UNKNOWN || pending[before].fetch_sub(1) > 1) return;
+                        checkLoss(before, board);
+                        extend(lossAt[before]);
+                    });
+                }
+            });
+        }
+        horizon = furthest.load();
+    }
+
+    // Everything still open is a draw
+    Generated& table = done[material.name];
+    table.material = material;
+    table.values.resize(size);
+    uint64_t wins = 0, losses = 0, draws = 0;
+    int longest = 0;
+    for (uint64_t i = 0; i < size; i++) {
+        uint8_t s = state[i];
+        if (s >= RESULT) {
+            int distance = s - RESULT;
+            table.values[i] = static_cast<uint8_t>(distance + 1);
+            if (distance % 2) {
+                wins++;
+                longest = std::max(longest, distance);
+            } else {
+                losses++;
+            }
+        } else {
+            table.values[i] = 0;
+            if (s != ILLEGAL) draws++;
+        }
+    }
+    state.reset();
+    pending.reset();
+    lossAt.reset();
+    captureWin.reset();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!write(directory, table, longest)) {
+        std::cerr << "Cannot write " << directory << "/" << material.name << ".tb\n";
+        return false;
+    }
+    std::error_code error;
+    auto bytes = std::filesystem::file_size(directory + "/" + material.name + ".tb", error);
+    std::cout << material.name << ": " << size << " entries, " << wins << " wins, " << losses << " losses, "
+              << draws << " draws, longest mate " << (longest + 1) / 2 << " moves, "
+              << static_cast<long long>(seconds * 1000) << " ms, " << bytes << " bytes" << std::endl;
+    return true;
+}
+
+// Average time of a probe over random legal positions of one table
+static double probeLatency(const Tablebases& tables, const TablebaseMaterial& material) {
+    std::mt19937_64 random(1);
+    std::vector<Board> positions;
+    Board board;
+    int squares[TB_MAX_PIECES];
+    Color us;
+    for (int attempt = 0; attempt < 100000 && positions.size() < 1000; attempt++) {
+        if (!decodeIndex(material, random() % material.size(), squares, us)) continue;
+        PiecePlacement placements[TB_MAX_PIECES];
+        for (int i = 0; i < material.count; i++) {
+            placements[i] = PiecePlacement{ material.colors[i], material.types[i], squares[i] };
+        }
+        board.setPosition(placements, material.count, us == WHITE);
+        if (!board.isInCheck(us == BLACK)) positions.push_back(board);
+    }
+    if (positions.empty()) return 0;
+
+    const int ROUNDS = 200;
+    volatile int sink = 0;  // Keeps the probes from being optimised away
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (const Board& position : positions) {
+            int wdl = 0, plies = 0;
+            tables.probe(position, wdl, plies);
+            sink = plies;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    (void)sink;
+    return seconds * 1e9 / (static_cast<double>(ROUNDS) * positions.size());
+}
+
+int runTablebaseGenerator(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: chess tbgen <directory> <table>... [threads n]\n"
+                     "Tables are named strong side first, e.g. KQvK KRvK KPvK KBNvK KQvKR\n";
+        return 1;
+    }
+    std::string directory = argv[0];
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    std::vector<std::string> names;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "threads" && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else {
+            names.push_back(argv[i]);
+        }
+    }
+    if (threads < 1) threads = 1;
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    auto start = std::chrono::steady_clock::now();
+    TablebaseGenerator generator(threads);
+    for (const std::string& name : names) {
+        if (!generator.generate(name, directory)) return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Generated in " << static_cast<long long>(seconds * 1000) << " ms on " << threads << " threads\n";
+
+    Tablebases tables;
+    tables.load(directory);
+    for (const std::string& name : names) {
+        TablebaseMaterial material;
+        material.parse(name);
+        std::cout << material.name << " probe: " << static_cast<int>(probeLatency(tables, material)) << " ns\n";
+    }
+    return 0;
+}
+
+int runTablebaseProbe(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: chess tbprobe <directory> <fen>\n";
+        return 1;
+    }
+    std::string fen;
+    for (int i = 1; i < argc; i++) {
+        fen += (i > 1 ? " " : "") + std::string(argv[i]);
+    }
+    Board board;
+    if (!board.fromFEN(fen)) {
+        std::cerr << "Invalid FEN " << fen << "\n";
+        return 1;
+    }
+    Tablebases tables;
+    std::cout << tables.load(argv[0]) << " tables loaded\n";
+
+    int wdl, plies;
+    if (!tables.probe(board, wdl, plies)) {
+        std::cout << "Position not covered\n";
+        return 2;
+    }
+    Move best = tables.bestMove(board);
+    if (wdl == 0) std::cout << "Draw";
+    else if (wdl > 0) std::cout << "Side to move mates in " << (plies + 1) / 2 << " (" << plies << " plies)";
+    else std::cout << "Side to move is mated in " << plies / 2 << " (" << plies << " plies)";
+    if (best != NO_MOVE) std::cout << ", best move " << moveToString(best);
+    std::cout << "\n";
+
+    auto start = std::chrono::steady_clock::now();
+    const int PROBES = 1000000;
+    volatile int sink = 0;
+    for (int i = 0; i < PROBES; i++) {
+        tables.probe(board, wdl, plies);
+        sink = plies;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    (void)sink;
+    std::cout << "Probe latency: " << static_cast<int>(seconds * 1e9 / PROBES) << " ns\n";
+    return 0;
+}
@@ -0,0 +1,103 @@
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include "Board.h"
+#include "MappedFile.h"
+#include "Move.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+// Largest endings the tables cover, kings included
+const int TB_MAX_PIECES = 4;
+
+// The pieces of one table, named strong side first ("KQvKR"). The table's
+// own piece order is white king, black king, then the other white and black
+// pieces in the order the name lists them; White is always the side named
+// first, so positions where Black has the stronger half are probed with the
+// colors swapped.
+struct TablebaseMaterial {
+    std::string name;
+    int count = 0;
+    Color colors[TB_MAX_PIECES];
+    PieceType types[TB_MAX_PIECES];
+    bool hasPawns = false;
+
+    // Accepts either side first ("KRvKQ" becomes "KQvKR"). False for names
+    // that are malformed, too large, have pawns on both sides (en passant is
+    // not modelled) or are dead draws that need no table.
+    bool parse(const std::string& text);
+
+    // Entries for both sides to move. Pawnless tables keep the white king in
+    // the a1-d1-d4 triangle (8 symmetries), tables with pawns keep it on the
+    // a-d files (left-right mirror only).
+    uint64_t size() const;
+};
+
+// Entry of a position given as squares in table order, after mapping it
+// onto the table's symmetry class
+uint64_t tablebaseIndex(const TablebaseMaterial& material, const int* squares, Color sideToMove);
+
+// The table for a position and its squares in that table's order, with the
+// colors swapped when Black holds the stronger half. False above
+// TB_MAX_PIECES pieces.
+bool tablebaseKey(const Board& board, std::string& name, int* squares, Color& sideToMove);
+
+// Memory-mapped tables written by `chess tbgen`. Each file holds a 64-byte
+// header and one packed value per entry: 0 for a draw, otherwise one more
+// than the distance to mate in plies (odd distances are wins for the side to
+// move, even ones losses). Probes read the mapping in place, so one set of
+// tables serves every search thread.
+class Tablebases {
+public:
+    // Maps every .tb file in the directory, replacing tables loaded before.
+    // Returns how many were found.
+    int load(const std::string& directory);
+    void clear();
+    bool isLoaded() const { return !tables.empty(); }
+    int maxPieces() const { return largest; }
+
+    // Result for the side to move (1 win, 0 draw, -1 loss) and the distance
+    // to mate in plies. The fifty-move rule is ignored. False when no loaded
+    // table covers the position.
+    bool probe(const Board& board, int& wdl, int& plies) const;
+
+    // The move that keeps the tablebase result: the fastest mate, a move that
+    // holds the draw, or the longest defence. NO_MOVE when the position is not
+    // covered or is already over.
+    Move bestMove(const Board& board) const;
+
+private:
+    struct Table {
+        TablebaseMaterial material;
+        MappedFile file;
+        int bits = 0;
+        uint64_t entries = 0;
+    };
+
+    // A loaded table and the color that holds its stronger half
+    struct Slot {
+        const Table* table = nullptr;
+        Color strong = WHITE;
+    };
+
+    // Material signatures of up to TB_MAX_PIECES - 2 pieces besides the
+    // kings; see materialSignature in Tablebase.cpp
+    static const int SIGNATURES = 11 * 11;
+
+    std::map<std::string, std::unique_ptr<Table>> tables;
+    Slot bySignature[SIGNATURES];  // Filled by load, so probes need no name
+    int largest = 0;
+};
+
+// Shared by the search and the game loop, like the NNUE network
+extern Tablebases tablebases;
+
+// Command line entries:
+//   tbgen <directory> <table>... [threads n]
+//   tbprobe <directory> <fen>
+int runTablebaseGenerator(int argc, char* argv[]);
+int runTablebaseProbe(int argc, char* argv[]);
+
+#endif // TABLEBASE_H
@@ -0,0 +1,112 @@
+// Regression checks for position setup, position keys and book keys, built as a separate program:
+//   g++ -std=c++17 -O2 -pthread Bitboard.cpp Board.cpp Piece.cpp Stats.cpp MappedFile.cpp Pgn.cpp Book.cpp Tests.cpp -o chess_tests
+//
+// chess_tests prints each failed check and exits with status 1 if any failed.
+
+#include "Board.h"
+#include "Book.h"
+#include <iostream>
+#include <string>
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cout << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+static bool hasMove(const Board& board, Move move) {
+    MoveList moves;
+    board.generateLegalMoves(board.isWhiteTurn ? WHITE : BLACK, moves);
+    for (Move m : moves) {
+        if (m == move) return true;
+    }
+    return false;
+}
+
+static void testFenEnPassant() {
+    Board board;
+
+    // A square on the right rank with an enemy pawn in front is kept
+    check(board.fromFEN("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1"), "fromFEN white en passant");
+    check(board.getEnPassantSquare() == makeSquare(5, 3), "white en passant square kept");
+    check(hasMove(board, encodeMove(makeSquare(4, 4), makeSquare(5, 3), EN_PASSANT)), "e5d6 en passant generated");
+
+    check(board.fromFEN("4k3/8/8/8/4Pp2/8/8/4K3 b - e3 0 1"), "fromFEN black en passant");
+    check(board.getEnPassantSquare() == makeSquare(2, 4), "black en passant square kept");
+
+    // A knight where the pushed pawn should be: capturing would remove it
+    check(board.fromFEN("4k3/8/8/3Pn3/8/8/8/4K3 w - e6 0 1"), "fromFEN knight behind square");
+    check(board.getEnPassantSquare() == NO_SQUARE, "square without a pushed pawn dropped");
+    check(!board.isValidMove(Position(4, 3), Position(5, 4)), "d5e6 rejected without a pawn on e5");
+    check(board.toFEN() == "4k3/8/8/3Pn3/8/8/8/4K3 w - - 0 1", "dropped square not written back");
+
+    // Rank of the wrong side to move
+    check(board.fromFEN("4k3/8/8/3pP3/8/8/8/4K3 b - d6 0 1"), "fromFEN wrong rank");
+    check(board.getEnPassantSquare() == NO_SQUARE, "square on the wrong rank dropped");
+
+    // Occupied target or occupied square behind it
+    check(board.fromFEN("4k3/8/3n4/3pP3/8/8/8/4K3 w - d6 0 1"), "fromFEN occupied target");
+    check(board.getEnPassantSquare() == NO_SQUARE, "occupied target dropped");
+    check(board.fromFEN("4k3/3n4/8/3pP3/8/8/8/4K3 w - d6 0 1"), "fromFEN occupied origin");
+    check(board.getEnPassantSquare() == NO_SQUARE, "occupied origin dropped");
+}
+
+// Positions that could not arise in a game, and bytes outside ASCII
+static void testFenRejected() {
+    Board board;
+    check(!board.fromFEN("4k3/8/8/8/8/8/8/r3K3 b - - 0 1"), "side not to move in check rejected");
+    check(board.fromFEN("4k3/8/8/8/8/8/8/r3K3 w - - 0 1"), "side to move in check accepted");
+    check(!board.fromFEN("4k3/8/8/8/8/8/8/4K2\xe9 w - - 0 1"), "non-ASCII piece letter rejected");
+}
+
+// The en passant file only enters the key when a capture is possible there
+static void testHashEnPassant() {
+    Board pushed;
+    pushed.makeMove(Position(1, 4), Position(3, 4));  // 1. e4, nothing can take
+    Board plain;
+    plain.fromFEN("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1");
+    check(pushed.hash() == plain.hash(), "uncapturable en passant square not hashed");
+
+    Board capturable;
+    capturable.fromFEN("4k3/8/8/8/4Pp2/8/8/4K3 b - e3 0 1");
+    Board without;
+    without.fromFEN("4k3/8/8/8/4Pp2/8/8/4K3 b - - 0 1");
+    check(capturable.hash() != without.hash(), "capturable en passant square hashed");
+}
+
+// Keys from the Polyglot book format description
+static void testPolyglotKeys() {
+    struct { const char* fen; uint64_t key; } cases[] = {
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 0x463b96181691fc9cULL },
+        { "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1", 0x823c9b50fd114196ULL },
+        { "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2", 0x0756b94461c50fb0ULL },
+        { "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2", 0x662fafb965db29d4ULL },
+        { "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", 0x22a48b5a8e47ff78ULL },
+        { "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3", 0x652a607ca3f242c1ULL },
+        { "rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4", 0x00fdd303c946bdd9ULL },
+        { "rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3", 0x3c8123ea7b067637ULL },
+        { "rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4", 0x5c3f9b829b279560ULL },
+    };
+    for (const auto& c : cases) {
+        Board board;
+        check(board.fromFEN(c.fen), std::string("fromFEN ") + c.fen);
+        check(polyglotKey(board) == c.key, std::string("Polyglot key of ") + c.fen);
+    }
+}
+
+int main() {
+    testFenEnPassant();
+    testFenRejected();
+    testHashEnPassant();
+    testPolyglotKeys();
+
+    if (failures) {
+        std::cout << failures << " check(s) failed\n";
+        return 1;
+    }
+    std::cout << "All checks passed\n";
+    return 0;
+}
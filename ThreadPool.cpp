@@ -0,0 +1,97 @@
+#include "ThreadPool.h"
+
+// Index of the pool worker running on this thread, -1 elsewhere
+static thread_local int workerIndex = -1;
+static thread_local const ThreadPool* workerPool = nullptr;
+
+ThreadPool::ThreadPool(int threadCount) : nextQueue(0), queued(0), unfinished(0), sleeping(0), stopping(false) {
+    if (threadCount < 1) threadCount = 1;
+    for (int i = 0; i < threadCount; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (int i = 0; i < threadCount; i++) {
+        threads.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    int index = (workerPool == this) ? workerIndex
+                                     : static_cast<int>(nextQueue.fetch_add(1) % queues.size());
+    unfinished++;
+    queued++;
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    if (sleeping > 0) {
+        // Taking the lock orders the notify after the sleeper's last check
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wake.notify_one();
+    }
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    idle.wait(lock, [this]() { return unfinished == 0; });
+}
+
+bool ThreadPool::take(int index, std::function<void()>& task) {
+    // Own queue first, oldest task first
+    {
+        Queue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.front());
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    // Then the newest task of another queue
+    int count = static_cast<int>(queues.size());
+    for (int i = 1; i < count; i++) {
+        Queue& other = *queues[(index + i) % count];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.tasks.empty()) {
+            task = std::move(other.tasks.back());
+            other.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(int index) {
+    workerIndex = index;
+    workerPool = this;
+    std::function<void()> task;
+    for (;;) {
+        if (take(index, task)) {
+            queued--;
+            task();
+            task = nullptr;
+            if (--unfinished == 0) {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                idle.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleeping++;
+        wake.wait(lock, [this]() { return queued > 0 || stopping; });
+        sleeping--;
+        if (stopping && queued == 0) return;
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads with one task queue each. A worker runs its own
+// queue oldest first and, when that is empty, steals the newest task from
+// another worker, so a burst of work on one queue spreads over all threads.
+// Tasks submitted from a worker go to that worker's queue.
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads);
+    ~ThreadPool();  // Runs the tasks still queued, then joins
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+
+    // Block until every task submitted so far has finished
+    void wait();
+
+    int size() const { return static_cast<int>(threads.size()); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<unsigned> nextQueue;
+
+    // queued counts tasks waiting in queues; it goes up before a push and
+    // down after a pop, so it never drops below the tasks really queued.
+    // sleepMutex is only taken to go to sleep and to wake a sleeper: a worker
+    // counts itself in sleeping before it looks at queued, and submit looks at
+    // sleeping after raising queued, so one of them always sees the other.
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::atomic<size_t> queued;
+    std::atomic<size_t> unfinished;
+    std::atomic<int> sleeping;
+    bool stopping;  // Guarded by sleepMutex
+
+    void run(int index);
+    bool take(int index, std::function<void()>& task);
+};
+
+#endif // THREAD_POOL_H
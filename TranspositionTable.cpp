@@ -0,0 +1,105 @@
+#include "TranspositionTable.h"
+
+// Data word layout:
+//   bits 0-15  move
+//   bits 16-31 score (signed)
+//   bits 32-39 depth
+//   bits 40-41 bound
+//   bits 48-55 generation
+static uint64_t pack(Move move, int score, int depth, Bound bound, uint8_t generation) {
+    return static_cast<uint64_t>(move) |
+           (static_cast<uint64_t>(static_cast<uint16_t>(score)) << 16) |
+           (static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 32) |
+           (static_cast<uint64_t>(bound) << 40) |
+           (static_cast<uint64_t>(generation) << 48);
+}
+
+static Move moveOf(uint64_t data) { return static_cast<Move>(data & 0xFFFF); }
+static int depthOf(uint64_t data) { return static_cast<int>((data >> 32) & 0xFF); }
+static uint8_t generationOf(uint64_t data) { return static_cast<uint8_t>(data >> 48); }
+
+TranspositionTable::TranspositionTable(size_t megabytes) : bucketCount(0), generation(0) {
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes) {
+    // Round down to a power of two so the key can be masked into an index
+    size_t count = 1;
+    while (count * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024) {
+        count *= 2;
+    }
+    if (count != bucketCount) {
+        buckets.reset(new Bucket[count]);
+        bucketCount = count;
+    }
+    clear();
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i < bucketCount; i++) {
+        for (Entry& e : buckets[i].entries) {
+            e.keyXorData.store(0, std::memory_order_relaxed);
+            e.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTData& out) const {
+    Bucket& bucket = bucketFor(key);
+    for (const Entry& e : bucket.entries) {
+        uint64_t data = e.data.load(std::memory_order_relaxed);
+        uint64_t check = e.keyXorData.load(std::memory_order_relaxed);
+        if (data != 0 && (check ^ data) == key) {
+            out.move = moveOf(data);
+            out.score = static_cast<int16_t>((data >> 16) & 0xFFFF);
+            out.depth = depthOf(data);
+            out.bound = static_cast<Bound>((data >> 40) & 3);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, Move move, int score, int depth, Bound bound) {
+    Bucket& bucket = bucketFor(key);
+
+    // Reuse the slot already holding this position, otherwise evict the
+    // entry that is shallowest once age is taken into account
+    Entry* replace = &bucket.entries[0];
+    int worst = 1 << 30;
+    for (Entry& e : bucket.entries) {
+        uint64_t data = e.data.load(std::memory_order_relaxed);
+        uint64_t check = e.keyXorData.load(std::memory_order_relaxed);
+        if (data == 0 || (check ^ data) == key) {
+            if (data != 0 && move == NO_MOVE) {
+                move = moveOf(data);  // Keep the known best move
+            }
+            replace = &e;
+            break;
+        }
+        int age = static_cast<uint8_t>(generation - generationOf(data));
+        int value = depthOf(data) - 8 * age;
+        if (value < worst) {
+            worst = value;
+            replace = &e;
+        }
+    }
+
+    uint64_t data = pack(move, score, depth, bound, generation);
+    replace->data.store(data, std::memory_order_relaxed);
+    replace->keyXorData.store(key ^ data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const {
+    int used = 0;
+    int sampled = 0;
+    for (size_t i = 0; i < bucketCount && sampled < 1000; i++) {
+        for (const Entry& e : buckets[i].entries) {
+            uint64_t data = e.data.load(std::memory_order_relaxed);
+            if (data != 0 && generationOf(data) == generation) used++;
+            sampled++;
+        }
+    }
+    return sampled ? used * 1000 / sampled : 0;
+}
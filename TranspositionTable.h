@@ -0,0 +1,59 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include "Move.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+enum Bound { BOUND_NONE, BOUND_UPPER, BOUND_LOWER, BOUND_EXACT };
+
+// What the table remembers about a searched position
+struct TTData {
+    Move move;
+    int score;
+    int depth;
+    Bound bound;
+};
+
+// Hash table of search results shared by all search threads without locks.
+// Each entry stores its key XORed with its data; a reader that sees a torn
+// write from another thread gets a key mismatch and treats it as a miss.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t megabytes = 16);
+
+    void resize(size_t megabytes);
+    void clear();
+
+    // Start of a new search; older entries become preferred for replacement
+    void newSearch() { generation++; }
+
+    bool probe(uint64_t key, TTData& data) const;
+    void store(uint64_t key, Move move, int score, int depth, Bound bound);
+
+    // Permille of sampled entries written during the current search
+    int hashfull() const;
+
+private:
+    static const int BUCKET_SIZE = 4;
+
+    struct Entry {
+        std::atomic<uint64_t> keyXorData;
+        std::atomic<uint64_t> data;
+    };
+
+    // One cache line per bucket
+    struct alignas(64) Bucket {
+        Entry entries[BUCKET_SIZE];
+    };
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t bucketCount;
+    uint8_t generation;
+
+    Bucket& bucketFor(uint64_t key) const { return buckets[key & (bucketCount - 1)]; }
+};
+
+#endif // TRANSPOSITION_TABLE_H
@@ -0,0 +1,250 @@
+#include "Uci.h"
+#include "Nnue.h"
+#include "Tablebase.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+// Score as UCI expects it: centipawns, or moves to mate (negative when mated)
+static std::string scoreToString(int score) {
+    if (score >= MATE_BOUND) {
+        return "mate " + std::to_string((MATE_SCORE - score + 1) / 2);
+    }
+    if (score <= -MATE_BOUND) {
+        return "mate " + std::to_string(-(MATE_SCORE + score) / 2);
+    }
+    return "cp " + std::to_string(score);
+}
+
+static std::string infoLine(const SearchResult& result) {
+    std::string line = "info depth " + std::to_string(result.depth) +
+                       " score " + scoreToString(result.score) +
+                       " nodes " + std::to_string(result.nodes) +
+                       " nps " + std::to_string(result.nps()) +
+                       " hashfull " + std::to_string(result.hashfull) +
+                       " time " + std::to_string(result.milliseconds) + " pv";
+    for (Move move : result.pv) {
+        line += " " + moveToString(move);
+    }
+    return line;
+}
+
+Uci::Uci() : gameKeys(1, board.hash()), useBook(false), stopRequested(false) {}
+
+Uci::~Uci() {
+    stopSearch();
+}
+
+void Uci::send(const std::string& line) {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::cout << line << std::endl;
+}
+
+void Uci::stopSearch() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        stopRequested = true;
+    }
+    stopSignal.notify_all();
+    search.stop();
+    if (searchThread.joinable()) {
+        searchThread.join();
+    }
+}
+
+// position [startpos | fen <fen>] [moves <move>...]
+void Uci::position(std::istringstream& args) {
+    std::string token;
+    args >> token;
+    if (token == "startpos") {
+        board.fromFEN(START_FEN);
+        args >> token;
+    } else if (token == "fen") {
+        std::string fen;
+        while (args >> token && token != "moves") {
+            fen += (fen.empty() ? "" : " ") + token;
+        }
+        if (!board.fromFEN(fen)) {
+            send("info string invalid FEN " + fen);
+            board.fromFEN(START_FEN);
+            gameKeys.assign(1, board.hash());
+            return;
+        }
+    } else {
+        return;
+    }
+
+    // The search needs the moves' positions to see repetitions; nothing
+    // before a capture or pawn move can recur
+    gameKeys.assign(1, board.hash());
+    while (args >> token) {
+        Move move = board.moveFromString(token);
+        if (move == NO_MOVE) {
+            send("info string illegal move " + token);
+            return;
+        }
+        UndoInfo undo;
+        board.doMove(move, undo);
+        if (board.getHalfmoveClock() == 0) {
+            gameKeys.clear();
+        }
+        gameKeys.push_back(board.hash());
+    }
+}
+
+// go [depth n] [nodes n] [movetime ms] [wtime ms] [btime ms] [winc ms] [binc ms]
+//    [movestogo n] [infinite]
+void Uci::go(std::istringstream& args) {
+    stopSearch();
+
+    SearchLimits limits;
+    bool infinite = false;
+    int time[2] = {0, 0};
+    int increment[2] = {0, 0};
+    int movesToGo = 0;
+    std::string token;
+    while (args >> token) {
+        if (token == "depth") args >> limits.depth;
+        else if (token == "nodes") args >> limits.nodes;
+        else if (token == "movetime") args >> limits.moveTime;
+        else if (token == "wtime") args >> time[WHITE];
+        else if (token == "btime") args >> time[BLACK];
+        else if (token == "winc") args >> increment[WHITE];
+        else if (token == "binc") args >> increment[BLACK];
+        else if (token == "movestogo") args >> movesToGo;
+        else if (token == "infinite") infinite = true;
+    }
+    limits.depth = std::min(std::max(limits.depth, 1), MAX_PLY - 1);
+
+    // With a clock, spend an even share of the remaining time plus most of the
+    // increment, keeping a margin for communication
+    Color us = board.isWhiteTurn ? WHITE : BLACK;
+    if (!limits.moveTime && time[us] > 0) {
+        int budget = time[us] / (movesToGo > 0 ? movesToGo : 30) + increment[us] * 3 / 4;
+        limits.moveTime = std::max(1, std::min(budget, time[us] - 50));
+    }
+
+    // Book moves are answered at once, except in analysis
+    if (useBook && !infinite) {
+        Move move = book.pickMove(board);
+        if (move != NO_MOVE) {
+            send("info string book move");
+            send("bestmove " + moveToString(move));
+            return;
+        }
+    }
+
+    stopRequested = false;
+    Board position = board;
+    std::vector<uint64_t> keys = gameKeys;
+    searchThread = std::thread([this, position, keys, limits, infinite]() {
+        SearchResult result = search.think(position, limits, [this](const SearchResult& r) {
+            send(infoLine(r));
+
+            // Catches a stop that arrived before think() started listening
+            std::lock_guard<std::mutex> lock(stopMutex);
+            if (stopRequested) search.stop();
+        }, keys);
+
+        if (infinite) {
+            std::unique_lock<std::mutex> lock(stopMutex);
+            stopSignal.wait(lock, [this]() { return stopRequested; });
+        }
+
+        send("info string first move cutoffs " + std::to_string(result.firstMoveCutoffs) + " of " +
+             std::to_string(result.betaCutoffs));
+
+        std::string line = "bestmove " + (result.bestMove == NO_MOVE ? std::string("0000") : moveToString(result.bestMove));
+        if (result.pv.size() > 1) {
+            line += " ponder " + moveToString(result.pv[1]);
+        }
+        send(line);
+    });
+}
+
+// setoption name <Hash|Threads|UseNNUE|EvalFile|OwnBook|BookFile|TablebasePath> value <value>
+void Uci::setOption(std::istringstream& args) {
+    std::string token, name, value;
+    args >> token >> name >> token;
+    std::getline(args >> std::ws, value);  // File names may contain spaces
+    int n = std::atoi(value.c_str());
+    if (name == "Hash" && n > 0) {
+        search.setHashSize(static_cast<size_t>(n));
+    } else if (name == "Threads" && n > 0) {
+        search.setThreads(n);
+    } else if (name == "UseNNUE") {
+        // Scores from the other evaluator would pollute the hash table
+        search.setUseNetwork(value == "true");
+        search.clearHash();
+        if (value == "true" && !nnueNetwork.isLoaded()) {
+            send("info string no network loaded, set EvalFile first");
+        }
+    } else if (name == "EvalFile") {
+        search.clearHash();
+        if (nnueNetwork.load(value)) {
+            send("info string loaded network " + value + " (" + Network::simdName() + ")");
+        } else {
+            send("info string cannot load network " + value);
+        }
+    } else if (name == "OwnBook") {
+        useBook = value == "true";
+    } else if (name == "BookFile") {
+        if (!book.open(value)) {
+            send("info string cannot open book " + value);
+        }
+    } else if (name == "TablebasePath") {
+        // Stored scores may predate the tables
+        search.clearHash();
+        send("info string loaded " + std::to_string(tablebases.load(value)) + " tablebases from " + value);
+    } else {
+        send("info string unknown option " + name);
+    }
+}
+
+void Uci::loop(std::istream& in) {
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream args(line);
+        std::string command;
+        args >> command;
+
+        if (command == "uci") {
+            send("id name Chess-Game");
+            send("id author Anish Chattopadhyay");
+            send("option name Hash type spin default 16 min 1 max 65536");
+            send("option name Threads type spin default 1 min 1 max 256");
+            send("option name UseNNUE type check default false");
+            send("option name EvalFile type string default <empty>");
+            send("option name OwnBook type check default false");
+            send("option name BookFile type string default <empty>");
+            send("option name TablebasePath type string default <empty>");
+            send("uciok");
+        } else if (command == "isready") {
+            send("readyok");
+        } else if (command == "ucinewgame") {
+            stopSearch();
+            search.clearHash();
+            board.fromFEN(START_FEN);
+            gameKeys.assign(1, board.hash());
+        } else if (command == "position") {
+            stopSearch();
+            position(args);
+        } else if (command == "go") {
+            go(args);
+        } else if (command == "stop") {
+            stopSearch();
+        } else if (command == "setoption") {
+            stopSearch();
+            setOption(args);
+        } else if (command == "quit") {
+            break;
+        }
+    }
+    stopSearch();
+}
+
+int runUci() {
+    Uci uci;
+    uci.loop(std::cin);
+    return 0;
+}
@@ -0,0 +1,49 @@
+#ifndef UCI_H
+#define UCI_H
+
+#include "Board.h"
+#include "Book.h"
+#include "Search.h"
+#include <condition_variable>
+#include <istream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Universal Chess Interface front end. Commands are read on the calling
+// thread while "go" runs the search on a thread of its own, so "stop" and
+// "isready" are answered while the engine is thinking.
+class Uci {
+public:
+    Uci();
+    ~Uci();
+
+    void loop(std::istream& in);
+
+private:
+    Board board;
+    std::vector<uint64_t> gameKeys;  // Positions since the last capture or pawn move, ending with board
+    Search search;
+    OpeningBook book;
+    bool useBook;
+    std::thread searchThread;
+    std::mutex outputMutex;
+
+    // "go infinite" must not report a move until told to stop
+    std::mutex stopMutex;
+    std::condition_variable stopSignal;
+    bool stopRequested;
+
+    void position(std::istringstream& args);
+    void go(std::istringstream& args);
+    void setOption(std::istringstream& args);
+    void stopSearch();
+    void send(const std::string& line);
+};
+
+// Command line entry: uci
+int runUci();
+
+#endif // UCI_H
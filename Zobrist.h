@@ -0,0 +1,47 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include "Bitboard.h"
+#include <cstdint>
+
+// Random keys XORed together to identify a position: one per piece on each
+// square, one for black to move, one per castling-rights combination and one
+// per en passant file.
+struct ZobristKeys {
+    uint64_t pieces[2][6][64];
+    uint64_t blackToMove;
+    uint64_t castling[16];
+    uint64_t enPassant[8];
+};
+
+// splitmix64, evaluated at compile time so the keys are identical in every build
+constexpr uint64_t nextZobrist(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys makeZobristKeys() {
+    ZobristKeys keys{};
+    uint64_t state = 0x5A0B1C2D3E4F6071ULL;
+    for (int c = 0; c < 2; c++) {
+        for (int t = 0; t < 6; t++) {
+            for (int sq = 0; sq < 64; sq++) {
+                keys.pieces[c][t][sq] = nextZobrist(state);
+            }
+        }
+    }
+    keys.blackToMove = nextZobrist(state);
+    for (int i = 0; i < 16; i++) {
+        keys.castling[i] = nextZobrist(state);
+    }
+    for (int i = 0; i < 8; i++) {
+        keys.enPassant[i] = nextZobrist(state);
+    }
+    return keys;
+}
+
+inline constexpr ZobristKeys ZOBRIST = makeZobristKeys();
+
+#endif // ZOBRIST_H
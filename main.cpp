@@ -1,13 +1,72 @@
 #include <iostream>
 #include <Windows.h>
+#include <string>
+#include <cstdlib>
 #include "Game.h"
 #include "Board.h"
+#include "Perft.h"
+#include "Pgn.h"
+#include "Uci.h"
+#include "Book.h"
+#include "Match.h"
+#include "Server.h"
+#include "Stats.h"
+#include "Tablebase.h"
 
-int main() {
+// Batch modes end by writing the rule-check counters to stderr as JSON when
+// they are compiled in
+static int finishBatch(int status) {
+    if (STATS_ENABLED) {
+        printStatsJson(std::cerr);
+    }
+    return status;
+}
+
+int main(int argc, char* argv[]) {
+    std::string mode = (argc > 1) ? argv[1] : "";
+    if (mode == "perft") {
+        return finishBatch(runPerft(argc - 2, argv + 2));
+    }
+    if (mode == "uci") {
+        return runUci();
+    }
+    if (mode == "server") {
+        return runServer(argc - 2, argv + 2);
+    }
+    if (mode == "makebook") {
+        return finishBatch(runMakeBook(argc - 2, argv + 2));
+    }
+    if (mode == "pgn") {
+        return finishBatch(runPgn(argc - 2, argv + 2));
+    }
+    if (mode == "match") {
+        return finishBatch(runMatch(argc - 2, argv + 2));
+    }
+    if (mode == "tbgen") {
+        return finishBatch(runTablebaseGenerator(argc - 2, argv + 2));
+    }
+    if (mode == "tbprobe") {
+        return finishBatch(runTablebaseProbe(argc - 2, argv + 2));
+    }
 
     try {
         // Create and start the chess game
         Game game;
+
+        // chess computer <white|black> [milliseconds] [threads] [book.bin|-] [tablebase dir]
+        // lets the engine play a side
+        if (mode == "computer") {
+            SearchLimits limits;
+            limits.moveTime = (argc > 3) ? std::atoi(argv[3]) : 1000;
+            game.setComputerPlayer(argc > 2 && std::string(argv[2]) == "white", limits);
+            game.setEngineThreads((argc > 4) ? std::atoi(argv[4]) : 1);
+            if (argc > 5 && std::string(argv[5]) != "-" && !game.setOpeningBook(argv[5])) {
+                std::cerr << "Cannot open book " << argv[5] << std::endl;
+            }
+            if (argc > 6 && !game.setTablebases(argv[6])) {
+                std::cerr << "No tablebases in " << argv[6] << std::endl;
+            }
+        }
         
         // Main game loop
         while (!game.isGameOver()) {
@@ -16,6 +75,11 @@ int main() {
             
             // Show whose turn it is
             std::cout << (game.isWhiteTurn() ? "White" : "Black") << "'s turn." << std::endl;
+
+            if (game.isComputerTurn()) {
+                game.executeComputerMove();
+                continue;
+            }
             
             // Get and execute the player's move
             if (!game.executePlayerMove()) {